@@ -0,0 +1,75 @@
+/**************************** colorbalance.cpp *************************
+
+Dialog with the brightness, contrast, hue and saturation controls
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include "./code/colorbalance/colorbalance.h"
+
+# include <QSlider>
+
+// Constructor
+ColorBalance::ColorBalance(QObject* parent) : QDialog()
+{
+	// setup the user interface
+	ui.setupUi(this);
+	
+	// the channel each slider controls, matched against the channel labels
+	// of the balance element
+	ui.horizontalSlider_brightness->setProperty("channel", "brightness");
+	ui.horizontalSlider_contrast->setProperty("channel", "contrast");
+	ui.horizontalSlider_hue->setProperty("channel", "hue");
+	ui.horizontalSlider_saturation->setProperty("channel", "saturation");
+	
+	// signals and slots
+	connect (ui.horizontalSlider_brightness, SIGNAL(valueChanged(int)), this, SLOT(sliderChanged(int)));
+	connect (ui.horizontalSlider_contrast, SIGNAL(valueChanged(int)), this, SLOT(sliderChanged(int)));
+	connect (ui.horizontalSlider_hue, SIGNAL(valueChanged(int)), this, SLOT(sliderChanged(int)));
+	connect (ui.horizontalSlider_saturation, SIGNAL(valueChanged(int)), this, SLOT(sliderChanged(int)));
+	connect (ui.pushButton_reset, SIGNAL(clicked()), this, SLOT(resetAll()));
+	connect (this, SIGNAL(balanceChanged(QString, int)), parent, SLOT(setColorBalance(QString, int)));
+}
+
+////////////////////////////// Private Slots ////////////////////////////
+//
+// Slot to pass a slider change on with the name of its channel
+void ColorBalance::sliderChanged(int value)
+{
+	QSlider* slider = qobject_cast<QSlider*>(sender());
+	if (slider) emit balanceChanged(slider->property("channel").toString(), value);
+	
+	return;
+}
+
+//
+// Slot to put every slider back to 0, no adjustment
+void ColorBalance::resetAll()
+{
+	ui.horizontalSlider_brightness->setValue(0);
+	ui.horizontalSlider_contrast->setValue(0);
+	ui.horizontalSlider_hue->setValue(0);
+	ui.horizontalSlider_saturation->setValue(0);
+	
+	return;
+}
@@ -0,0 +1,59 @@
+/**************************** colorbalance.h ***************************
+
+Dialog with the brightness, contrast, hue and saturation controls
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef COLORBALANCE_H
+# define COLORBALANCE_H
+
+# include <QDialog>
+# include <QString>
+
+# include "ui_colorbalance.h"
+
+//	Dialog to adjust the color balance.  Values run from -100 to 100 with 0
+//	meaning no adjustment, GST_Interface maps them onto the channels of the
+//	balance element it finds.
+class ColorBalance : public QDialog
+{
+	Q_OBJECT
+	
+	public:
+		ColorBalance (QObject*);
+		inline void updateMethod(const QString& s) {ui.label_method->setText(s);}
+	
+	signals:
+		void balanceChanged(const QString&, int);
+	
+	private:
+	// members
+		Ui::ColorBalance ui;
+	
+	private slots:
+		void sliderChanged(int);
+		void resetAll();
+};
+
+# endif
@@ -0,0 +1,486 @@
+/**************************** decbench.cpp *****************************
+
+Class to benchmark the video decoders and video sinks installed on this
+machine and keep the fastest ranking for each codec
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include <gst/pbutils/pbutils.h>
+# include <gst/video/videooverlay.h>
+
+# include <QtCore/QDebug>
+# include <QProcessEnvironment>
+# include <QCryptographicHash>
+# include <QElapsedTimer>
+# include <QSettings>
+# include <QFileInfo>
+# include <QFile>
+# include <QDir>
+# include <QUrl>
+# include <QPair>
+# include <QList>
+
+# include <algorithm>
+
+# include "./code/decbench/decbench.h"
+# include "./code/gstiface/gstiface.h"
+# include "./code/resource.h"
+
+// Constants
+static const gint64 sample_time = 10 * GST_SECOND;				// decode this much of each sample file
+static const GstClockTime max_run_time = 120 * GST_SECOND;	// give up on a candidate after this long
+
+// Callback Function: Link the first parsed stream the decoder accepts.  Other
+// streams (audio, a second video stream) are left unlinked.
+static void benchPadAdded(GstElement* src, GstPad* pad, GstElement* decoder)
+{
+	(void) src;
+
+	GstPad* sinkpad = gst_element_get_static_pad(decoder, "sink");
+	if (! gst_pad_is_linked(sinkpad) ) gst_pad_link(pad, sinkpad);
+	gst_object_unref(sinkpad);
+
+	return;
+}
+
+/////////////////////////////// BenchmarkWorker ///////////////////////////
+//
+// Constructor
+BenchmarkWorker::BenchmarkWorker() : QObject()
+{
+	abort.store(0);
+	window_handle = 0;
+}
+
+//
+// Slot to run the benchmark on the files in corpus.  Called through a queued
+// connection so this runs in the worker thread.  For each video codec found
+// the decoders that can handle it are timed decoding to a fakesink, then the
+// video sinks are timed behind the fastest decoder for that codec.  The
+// finished signal carries the ranking: codec caps name to a QStringList of
+// decoders, fastest first, and "video-sink:" plus the codec caps name to a
+// QStringList of sinks for that codec, fastest first.
+void BenchmarkWorker::run(const QString& corpus)
+{
+	QVariantMap ranking;
+	QStringList files;
+	QFileInfoList fil = QDir(corpus).entryInfoList(QDir::Files | QDir::Readable, QDir::Name);
+	for (int i = 0; i < fil.count(); ++i) {
+		files << fil.at(i).absoluteFilePath();
+	}
+
+	// one sample file per codec
+	const QMap<QString, QString> samples = probeCodecs(files);
+	QMap<QString, QString>::const_iterator it;
+	for (it = samples.constBegin(); it != samples.constEnd(); ++it) {
+		if (abort.load() ) break;
+		const QStringList decoders = rankDecoders(it.key(), it.value() );
+		if (decoders.isEmpty() ) {
+			emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: no working decoder for %1")).arg(it.key()) );
+			continue;
+		}
+		ranking.insert(it.key(), decoders);
+		emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: decoders for %1, fastest first: %2")).arg(it.key()).arg(decoders.join(", ")) );
+
+		// video sinks, behind the decoder that will be used for this codec
+		if (abort.load() ) break;
+		const QStringList sinks = rankSinks(decoders.first(), it.value() );
+		if (! sinks.isEmpty() ) {
+			ranking.insert(QString("video-sink:%1").arg(it.key()), sinks);
+			emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: video sinks for %1, fastest first: %2")).arg(it.key()).arg(sinks.join(", ")) );
+		}
+	}	// for
+
+	emit finished(ranking);
+	return;
+}
+
+//
+// Function to find the video codecs in a list of files.  Return a map of
+// codec caps name (for instance video/x-h264) to the first file using it.
+QMap<QString, QString> BenchmarkWorker::probeCodecs(const QStringList& files)
+{
+	QMap<QString, QString> samples;
+	GError* err = NULL;
+
+	GstDiscoverer* disc = gst_discoverer_new(5 * GST_SECOND, &err);
+	if (! disc) {
+		emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: error creating a gst_discoverer instance: %1")).arg(err ? err->message : "") );
+		g_clear_error(&err);
+		return samples;
+	}
+
+	for (int i = 0; i < files.count(); ++i) {
+		GstDiscovererInfo* info = gst_discoverer_discover_uri(disc, QUrl::fromLocalFile(files.at(i)).toEncoded().constData(), &err);
+		g_clear_error(&err);
+		if (! info) continue;
+
+		if (gst_discoverer_info_get_result(info) == GST_DISCOVERER_OK) {
+			GList* streams = gst_discoverer_info_get_video_streams(info);
+			for (GList* l = streams; l != NULL; l = l->next) {
+				if (gst_discoverer_video_info_is_image(GST_DISCOVERER_VIDEO_INFO(l->data)) ) continue;
+				GstCaps* caps = gst_discoverer_stream_info_get_caps(GST_DISCOVERER_STREAM_INFO(l->data) );
+				if (! caps) continue;
+				if (gst_caps_get_size(caps) > 0) {
+					const QString codec = QString(gst_structure_get_name(gst_caps_get_structure(caps, 0)) );
+					if (codec != "video/x-raw" && ! samples.contains(codec) ) samples.insert(codec, files.at(i) );
+				}
+				gst_caps_unref(caps);
+			}	// for
+			gst_discoverer_stream_info_list_free(streams);
+		}	// if result ok
+
+		gst_discoverer_info_unref(info);
+	}	// for
+
+	g_object_unref(disc);
+	return samples;
+}
+
+//
+// Function to time every decoder that accepts codec on file.  Return the
+// decoders that worked, fastest first.
+QStringList BenchmarkWorker::rankDecoders(const QString& codec, const QString& file)
+{
+	QList<QPair<double, QString> > times;
+
+	GList* decoders = gst_element_factory_list_get_elements((GstElementFactoryListType)(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO), GST_RANK_MARGINAL);
+	GstCaps* caps = gst_caps_new_empty_simple(qPrintable(codec) );
+	GList* candidates = gst_element_factory_list_filter(decoders, caps, GST_PAD_SINK, FALSE);
+
+	for (GList* l = candidates; l != NULL && ! abort.load(); l = l->next) {
+		const QString name = QString(GST_OBJECT_NAME(l->data) );
+		const double secs = timePipeline(file, name, QString("fakesink") );
+		if (secs < 0.0)
+			emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: %1 failed to decode %2")).arg(name).arg(file) );
+		else {
+			emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: %1 decoded %2 in %3 seconds")).arg(name).arg(codec).arg(secs, 0, 'f', 2) );
+			times.append(qMakePair(secs, name) );
+		}
+	}	// for
+
+	gst_plugin_feature_list_free(candidates);
+	gst_plugin_feature_list_free(decoders);
+	gst_caps_unref(caps);
+
+	std::sort(times.begin(), times.end() );
+	QStringList ranked;
+	for (int i = 0; i < times.count(); ++i) {
+		ranked << times.at(i).second;
+	}
+
+	return ranked;
+}
+
+//
+// Function to time the video sinks we can embed (they implement
+// GstVideoOverlay) showing file decoded by decoder.  The sinks draw into
+// a window that is never shown, without one each would open its own.
+// Return the sinks that worked, fastest first.
+QStringList BenchmarkWorker::rankSinks(const QString& decoder, const QString& file)
+{
+	QList<QPair<double, QString> > times;
+	if (window_handle == 0) return QStringList();
+
+	GList* sinks = gst_element_factory_list_get_elements((GstElementFactoryListType)(GST_ELEMENT_FACTORY_TYPE_SINK | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO), GST_RANK_MARGINAL);
+	for (GList* l = sinks; l != NULL && ! abort.load(); l = l->next) {
+		if (! gst_element_factory_has_interface(GST_ELEMENT_FACTORY(l->data), "GstVideoOverlay") ) continue;
+		const QString name = QString(GST_OBJECT_NAME(l->data) );
+		const double secs = timePipeline(file, decoder, name);
+		if (secs < 0.0)
+			emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: video sink %1 failed")).arg(name) );
+		else {
+			emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: video sink %1 took %2 seconds")).arg(name).arg(secs, 0, 'f', 2) );
+			times.append(qMakePair(secs, name) );
+		}
+	}	// for
+	gst_plugin_feature_list_free(sinks);
+
+	std::sort(times.begin(), times.end() );
+	QStringList ranked;
+	for (int i = 0; i < times.count(); ++i) {
+		ranked << times.at(i).second;
+	}
+
+	return ranked;
+}
+
+//
+// Function to time filesrc ! parsebin ! decoder ! sink on the first
+// sample_time of file, unsynchronized so it runs as fast as possible.
+// The decoder is linked straight to the sink, as playbin would link it when
+// the formats match.  Only if that link fails is a videoconvert put in
+// between.  A sink other than fakesink is given our hidden window.  Return
+// the wall clock time in seconds, or -1.0 if the pipeline failed.
+double BenchmarkWorker::timePipeline(const QString& file, const QString& decoder, const QString& sink)
+{
+	const bool decode_only = (sink == "fakesink");
+	GstElement* pipeline = gst_pipeline_new("mbmp_benchmark");
+	GstElement* source = gst_element_factory_make("filesrc", NULL);
+	GstElement* parse = gst_element_factory_make("parsebin", NULL);
+	GstElement* dec = gst_element_factory_make(qPrintable(decoder), NULL);
+	GstElement* vsink = gst_element_factory_make(qPrintable(sink), NULL);
+
+	if (! pipeline || ! source || ! parse || ! dec || ! vsink) {
+		if (pipeline) gst_object_unref(GST_OBJECT(pipeline));
+		if (source) gst_object_unref(GST_OBJECT(source));
+		if (parse) gst_object_unref(GST_OBJECT(parse));
+		if (dec) gst_object_unref(GST_OBJECT(dec));
+		if (vsink) gst_object_unref(GST_OBJECT(vsink));
+		return -1.0;
+	}
+
+	g_object_set(G_OBJECT(source), "location", QFile::encodeName(file).constData(), NULL);
+	g_object_set(G_OBJECT(vsink), "sync", FALSE, NULL);
+	if (! decode_only && GST_IS_VIDEO_OVERLAY(vsink) ) gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(vsink), window_handle);
+
+	gst_bin_add_many(GST_BIN(pipeline), source, parse, dec, vsink, NULL);
+	bool linked = gst_element_link(source, parse);
+	if (linked && ! gst_element_link(dec, vsink) ) {
+		GstElement* convert = decode_only ? NULL : gst_element_factory_make("videoconvert", NULL);
+		if (convert) {
+			gst_bin_add(GST_BIN(pipeline), convert);
+			linked = gst_element_link_many(dec, convert, vsink, NULL);
+		}
+		else
+			linked = false;
+	}	// if direct link failed
+	if (! linked) {
+		gst_object_unref(GST_OBJECT(pipeline));
+		return -1.0;
+	}
+	g_signal_connect(parse, "pad-added", G_CALLBACK(&benchPadAdded), dec);
+
+	// preroll, then decode the same stretch of every file
+	double secs = -1.0;
+	GstBus* bus = gst_element_get_bus(pipeline);
+	gst_element_set_state(pipeline, GST_STATE_PAUSED);
+	if (gst_element_get_state(pipeline, NULL, NULL, 10 * GST_SECOND) == GST_STATE_CHANGE_SUCCESS) {
+		gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME, (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
+			GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, sample_time);
+		gst_element_get_state(pipeline, NULL, NULL, 10 * GST_SECOND);
+
+		QElapsedTimer timer;
+		timer.start();
+		gst_element_set_state(pipeline, GST_STATE_PLAYING);
+		GstMessage* msg = gst_bus_timed_pop_filtered(bus, max_run_time, (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR) );
+		if (msg) {
+			if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS) secs = timer.elapsed() / 1000.0;
+			gst_message_unref(msg);
+		}
+	}	// if prerolled
+
+	gst_object_unref(bus);
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(GST_OBJECT(pipeline));
+
+	return secs;
+}
+
+/////////////////////////////// DecoderBenchmark //////////////////////////
+//
+// Constructor
+DecoderBenchmark::DecoderBenchmark(QObject* parent) : QObject(parent)
+{
+	// data members
+	running = false;
+	pending.clear();
+	offscreen = NULL;
+
+	// ranking file and default corpus live under XDG_DATA_HOME
+	QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+	const QString data_home = QString(env.value("XDG_DATA_HOME", QString(QDir::homePath()) + "/.local/share") + "/%1").arg(QString(APP).toLower());
+	ranking_file = data_home + "/decoder_ranking.conf";
+	corpus_dir = data_home + "/benchmark";
+
+	// the worker runs at idle priority so a benchmark does not disturb playback
+	thread = new QThread(this);
+	worker = new BenchmarkWorker();
+	worker->moveToThread(thread);
+
+	connect (thread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+	connect (this, SIGNAL(runRequested(QString)), worker, SLOT(run(QString)));
+	connect (worker, SIGNAL(signalMessage(int, QString)), this, SIGNAL(signalMessage(int, QString)));
+	connect (worker, SIGNAL(finished(QVariantMap)), this, SLOT(workerFinished(QVariantMap)));
+
+	thread->start(QThread::IdlePriority);
+}
+
+// Destructor
+DecoderBenchmark::~DecoderBenchmark()
+{
+	worker->setAbort(true);
+	thread->quit();
+	thread->wait();
+	if (offscreen) delete offscreen;
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to start a benchmark in the background using the files in
+// corpus.  An empty corpus means our default directory.
+void DecoderBenchmark::start(const QString& corpus)
+{
+	if (running) return;
+
+	const QString dir = corpus.isEmpty() ? corpus_dir : corpus;
+	if (! corpusAvailable(dir) ) {
+		emit signalMessage(MBMP_GI::Application, QString(tr("Benchmark: no sample files found in %1")).arg(dir) );
+		return;
+	}
+
+	// a native window for the video sinks to draw into, it is never shown
+	if (! offscreen) {
+		offscreen = new QWidget();
+		offscreen->setAttribute(Qt::WA_NativeWindow);
+		offscreen->setAttribute(Qt::WA_DontShowOnScreen);
+		offscreen->resize(640, 360);
+	}
+	worker->setWindowHandle(static_cast<guintptr>(offscreen->winId()) );
+
+	running = true;
+	pending.clear();
+	emit signalMessage(MBMP_GI::Application, QString(tr("Starting the decoder benchmark using the files in %1")).arg(dir) );
+	emit runRequested(dir);
+
+	return;
+}
+
+//
+// Function to restore the saved ranking.  Emits rankingReady if the saved
+// ranking matches the current GStreamer registry.  If the registry changed
+// since it was made the benchmark is run again on the default corpus (if
+// there is one), but not until playback stops so it does not compete with
+// the player for the decoders.  No ranking at all means the user never
+// asked for one, leave it at that.
+void DecoderBenchmark::restore()
+{
+	if (! QFile::exists(ranking_file) ) return;
+
+	QSettings settings(ranking_file, QSettings::IniFormat);
+	if (settings.value("registry").toString() != registryFingerprint() ) {
+		emit signalMessage(MBMP_GI::Application, tr("GStreamer registry has changed since the last decoder benchmark, the saved ranking is not used") );
+		if (corpusAvailable(corpus_dir) ) {
+			pending = corpus_dir;
+			emit signalMessage(MBMP_GI::Application, tr("The decoder benchmark will run again when playback stops") );
+		}
+		return;
+	}
+
+	QVariantMap ranking;
+	const int size = settings.beginReadArray("codecs");
+	for (int i = 0; i < size; ++i) {
+		settings.setArrayIndex(i);
+		const QString codec = settings.value("caps").toString();
+		ranking.insert(codec, settings.value("decoders").toStringList() );
+		if (settings.contains("sinks") ) ranking.insert(QString("video-sink:%1").arg(codec), settings.value("sinks").toStringList() );
+	}
+	settings.endArray();
+
+	emit rankingReady(ranking);
+	return;
+}
+
+//
+// Function to run the benchmark restore() put off, if there is one.  Call
+// when playback stops.
+void DecoderBenchmark::runPending()
+{
+	if (pending.isEmpty() ) return;
+
+	this->start(pending);
+
+	return;
+}
+
+//
+// Function to return a fingerprint of the video decoders and sinks in the
+// GStreamer registry.  Plugin versions are included so an upgrade counts
+// as a change.  Ranks are not, we change those ourselves at startup.
+QString DecoderBenchmark::registryFingerprint()
+{
+	QStringList sl;
+	GList* list = gst_element_factory_list_get_elements((GstElementFactoryListType)(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO), GST_RANK_NONE);
+	list = g_list_concat(list, gst_element_factory_list_get_elements((GstElementFactoryListType)(GST_ELEMENT_FACTORY_TYPE_SINK | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO), GST_RANK_NONE) );
+
+	for (GList* l = list; l != NULL; l = l->next) {
+		GstPlugin* plugin = gst_plugin_feature_get_plugin(GST_PLUGIN_FEATURE(l->data) );
+		sl << QString("%1:%2").arg(GST_OBJECT_NAME(l->data)).arg(plugin ? gst_plugin_get_version(plugin) : "");
+		if (plugin) gst_object_unref(plugin);
+	}
+	gst_plugin_feature_list_free(list);
+	sl.sort();
+
+	gchar* version = gst_version_string();
+	sl.prepend(QString(version) );
+	g_free(version);
+
+	return QString(QCryptographicHash::hash(sl.join("\n").toUtf8(), QCryptographicHash::Md5).toHex() );
+}
+
+///////////////////////////// Private Functions /////////////////////////
+//
+// Function to return true if dir exists and contains readable files
+bool DecoderBenchmark::corpusAvailable(const QString& dir)
+{
+	QDir d(dir);
+	return (d.exists() && ! d.entryList(QDir::Files | QDir::Readable).isEmpty() );
+}
+
+//////////////////////////// Private Slots //////////////////////////
+//
+// Slot to receive the ranking from the worker thread, save it with the
+// registry fingerprint and pass it on
+void DecoderBenchmark::workerFinished(const QVariantMap& ranking)
+{
+	running = false;
+	if (ranking.isEmpty() ) {
+		emit signalMessage(MBMP_GI::Application, tr("Benchmark finished without finding a working decoder, nothing saved") );
+		return;
+	}
+
+	QDir().mkpath(QFileInfo(ranking_file).absolutePath() );
+	QSettings settings(ranking_file, QSettings::IniFormat);
+	settings.clear();
+	settings.setValue("registry", registryFingerprint() );
+
+	int idx = 0;
+	settings.beginWriteArray("codecs");
+	QVariantMap::const_iterator it;
+	for (it = ranking.constBegin(); it != ranking.constEnd(); ++it) {
+		if (it.key().startsWith("video-sink:") ) continue;
+		settings.setArrayIndex(idx++);
+		settings.setValue("caps", it.key() );
+		settings.setValue("decoders", it.value().toStringList() );
+		const QString sinks = QString("video-sink:%1").arg(it.key());
+		if (ranking.contains(sinks) ) settings.setValue("sinks", ranking.value(sinks).toStringList() );
+	}
+	settings.endArray();
+	settings.sync();
+
+	emit signalMessage(MBMP_GI::Application, QString(tr("Decoder benchmark finished, ranking saved to %1")).arg(ranking_file) );
+	emit rankingReady(ranking);
+
+	return;
+}
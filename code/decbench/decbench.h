@@ -0,0 +1,113 @@
+/**************************** decbench.h *******************************
+
+Class to benchmark the video decoders and video sinks installed on this
+machine and keep the fastest ranking for each codec
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef DECBENCH_H
+# define DECBENCH_H
+
+# include <gst/gst.h>
+
+# include <QObject>
+# include <QThread>
+# include <QString>
+# include <QStringList>
+# include <QMap>
+# include <QAtomicInt>
+# include <QVariantMap>
+# include <QWidget>
+
+//	Worker class, lives in its own low priority thread and runs the
+//	benchmark pipelines.  Only DecoderBenchmark should use this.
+class BenchmarkWorker : public QObject
+{
+	Q_OBJECT
+
+	public:
+		BenchmarkWorker();
+		inline void setAbort(bool b) {abort.store(b ? 1 : 0);}
+		inline void setWindowHandle(guintptr h) {window_handle = h;}
+
+	public slots:
+		void run(const QString&);
+
+	signals:
+		void signalMessage(int, QString);
+		void finished(const QVariantMap&);
+
+	private:
+		// members
+		QAtomicInt abort;
+		guintptr window_handle;
+
+		// functions
+		QMap<QString, QString> probeCodecs(const QStringList&);
+		QStringList rankDecoders(const QString&, const QString&);
+		QStringList rankSinks(const QString&, const QString&);
+		double timePipeline(const QString&, const QString&, const QString&);
+};
+
+//	Class to time the candidate decoders and video sinks for each codec
+//	found in a corpus of sample files.  The ranking is kept on disk with a
+//	fingerprint of the GStreamer registry, when the registry changes the
+//	ranking is stale and the benchmark is run again.
+class DecoderBenchmark : public QObject
+{
+	Q_OBJECT
+
+	public:
+		DecoderBenchmark(QObject*);
+		~DecoderBenchmark();
+
+		void start(const QString&);
+		void restore();
+		void runPending();
+		inline bool isRunning() {return running;}
+		static QString registryFingerprint();
+
+	signals:
+		void signalMessage(int, QString);
+		void rankingReady(const QVariantMap&);
+		void runRequested(const QString&);
+
+	private:
+		// members
+		QThread* thread;
+		BenchmarkWorker* worker;
+		QString ranking_file;
+		QString corpus_dir;
+		QString pending;
+		QWidget* offscreen;
+		bool running;
+
+		// functions
+		bool corpusAvailable(const QString&);
+
+	private slots:
+		void workerFinished(const QVariantMap&);
+};
+
+# endif
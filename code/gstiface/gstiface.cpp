@@ -30,11 +30,99 @@ DEALINGS IN THE SOFTWARE.
 # include "./code/playerctl/playerctl.h"  
 
 # include "./code/resource.h"
+# include "./code/spectrum/spectrum.h"
 
 # include <QDebug>
 # include <QWidget>
 # include <QTime>
 # include <QMessageBox>
+# include <QRegExp>
+# include <QProcessEnvironment>
+# include <QDir>
+# include <QUrl>
+# include <QFileInfo>
+
+# include <pthread.h>
+# include <sched.h>
+# include <errno.h>
+# include <string.h>
+# include <unistd.h>
+# include <sys/resource.h>
+# include <sys/syscall.h>
+
+// Constants for adaptive stream buffering
+static const gint64 min_buffer_time = 2 * GST_SECOND;		// buffer duration on a fast connection
+static const gint64 max_buffer_time = 30 * GST_SECOND;	// never buffer more than this
+static const int max_stall_level = 3;										// buffer_time doubles per level
+static const qint64 stall_window = 15 * 1000;						// a stall this soon (ms) after resuming means the buffer is too small
+static const qint64 relax_window = 120 * 1000;					// smooth playback this long (ms) relaxes one stall level
+
+// Constants for the QoS statistics
+static const int qos_interval = 2 * 1000;			// length (ms) of a QoS statistics window
+static const double qos_drop_high = 0.05;			// dropping more than this fraction of video frames raises the alert
+static const double qos_drop_low = 0.01;			// and less than this clears it
+static const double qos_late_high = 1.2;			// a proportion above this raises the alert
+static const double qos_late_low = 1.0;				// and below this clears it
+static const qint64 qos_hold = 10 * 1000;			// the alert is held at least this long (ms)
+
+// Constants for the quality degradation ladder.  Steps are taken in order
+// under sustained QoS pressure and undone in reverse when it goes away.
+// Skipping frames shows the most so it comes last, downscaling is only
+// there with window scaling on.
+static const int max_degrade_level = 4;
+static const char* degrade_steps[] = {
+	"",
+	QT_TRANSLATE_NOOP("GST_Interface", "lower visualizer framerate"),
+	QT_TRANSLATE_NOOP("GST_Interface", "cheaper deinterlacing"),
+	QT_TRANSLATE_NOOP("GST_Interface", "downscale before the video sink"),
+	QT_TRANSLATE_NOOP("GST_Interface", "decoders skip non-reference frames"),
+};
+static const int degrade_vis_fps = 10;				// visualizer framerate on the first step
+static const int degrade_step_windows = 2;		// QoS windows to wait for a step to take effect before the next
+static const int degrade_calm_windows = 5;		// QoS windows under the threshold before undoing a step
+static const int window_scale_step = 128;			// window scaling target, window size rounded up to this many pixels
+
+// Constant for keyframe only decoding of a hidden video
+static const int hide_delay = 5 * 1000;				// the video must stay hidden this long (ms) before we seek
+
+// Pipeline tuning profiles, selected with GST_Interface::setTuningProfile().
+// Sizes of 0 and durations of -1 (or 0 for the audio sink) leave the
+// playbin or element default in place.  The flags are only ever the
+// buffering flags in tuning_flag_mask, the default profile puts back the
+// ones the user had.
+struct TuningProfile
+{
+	const char* name;					// name used in the settings and on the command line
+	gint64 buffer_duration;		// playbin buffer-duration in ns, floor for tuneBuffering()
+	gint buffer_size;					// playbin buffer-size in bytes
+	guint queue_bytes;				// decodebin multiqueue max-size-bytes
+	guint64 queue_time;				// decodebin multiqueue max-size-time in ns
+	gint64 sink_buffer;				// audio sink buffer-time in us
+	gint64 sink_latency;			// audio sink latency-time in us
+	guint flags_set;					// GstPlayFlags to set
+	guint flags_clear;				// GstPlayFlags to clear
+	bool adaptive;						// let tuneBuffering() grow the stream buffer
+};
+
+static const TuningProfile tuning_profiles[] = {
+	{"default", -1, -1, 0, 0, 0, 0, 0, 0, true},
+	{"low-latency", 500 * GST_MSECOND, 256 * 1024, 2 * 1024 * 1024, 200 * GST_MSECOND, 40000, 10000,
+		0, GST_PLAY_FLAG_BUFFERING | GST_PLAY_FLAG_DOWNLOAD, false},
+	{"low-memory", 2 * GST_SECOND, 512 * 1024, 2 * 1024 * 1024, 1 * GST_SECOND, 0, 0,
+		GST_PLAY_FLAG_BUFFERING, GST_PLAY_FLAG_DOWNLOAD, false},
+	{"high-throughput", 10 * GST_SECOND, 20 * 1024 * 1024, 64 * 1024 * 1024, 5 * GST_SECOND, 500000, 20000,
+		GST_PLAY_FLAG_BUFFERING | GST_PLAY_FLAG_DOWNLOAD, 0, true},
+};
+static const int n_tuning_profiles = sizeof(tuning_profiles) / sizeof(tuning_profiles[0]);
+static const guint tuning_flag_mask = GST_PLAY_FLAG_BUFFERING | GST_PLAY_FLAG_DOWNLOAD;
+
+// Limits applied to the buffering queues by setBufferLimits()
+struct BufferLimits
+{
+	gint64 time;		// queue2 max-size-time in ns
+	gdouble low;		// low watermark, 0.0 to 1.0
+	gdouble high;		// high watermark, 0.0 to 1.0
+};
 
 //  Callback Function: Return TRUE if the element is of type defined in data
 static gboolean filter_features (GstPluginFeature *feature, gpointer data)
@@ -77,6 +165,276 @@ static gboolean busCallback(GstBus* bus, GstMessage* msg, gpointer data)
 	return TRUE;
 }
 
+// Callback Function: Synchronous bus handler, runs in the thread that posted
+// the message.  A streaming thread entering its loop posts a stream status
+// ENTER message from inside that thread, which is the one place we can set
+// its priority and affinity.  Everything is passed on to the bus watch.
+static GstBusSyncReply busSyncHandler(GstBus* bus, GstMessage* msg, gpointer data)
+{
+	(void) bus;
+	
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STREAM_STATUS) {
+		GST_Interface* gstif = (GST_Interface*) data;
+		gstif->threadEntered(msg);
+	}
+	
+	return GST_BUS_PASS;
+}
+
+// Callback Function: Apply the BufferLimits in data to an element if it is
+// one of the queues playbin uses for stream buffering.  Called for each
+// element in the pipeline from GST_Interface::tuneBuffering()
+static void setBufferLimits(const GValue* item, gpointer data)
+{
+	GstElement* element = GST_ELEMENT(g_value_get_object(item));
+	const BufferLimits* lim = (const BufferLimits*) data;
+	
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory) return;
+	const QString name = QString(GST_OBJECT_NAME(factory));
+	if (name != "queue2" && name != "multiqueue") return;
+	
+	// decodebin manages the multiqueue size itself, only set the queue2 size
+	if (name == "queue2") g_object_set(G_OBJECT(element), "max-size-time", static_cast<guint64>(lim->time), NULL);
+	
+	// watermarks are doubles since GStreamer 1.10, percentages before that
+	GObjectClass* klass = G_OBJECT_GET_CLASS(element);
+	if (g_object_class_find_property(klass, "high-watermark") )
+		g_object_set(G_OBJECT(element), "low-watermark", lim->low, "high-watermark", lim->high, NULL);
+	else if (g_object_class_find_property(klass, "high-percent") )
+		g_object_set(G_OBJECT(element), "low-percent", static_cast<gint>(lim->low * 100), "high-percent", static_cast<gint>(lim->high * 100), NULL);
+	
+	return;
+}
+
+// Callback Function: Pass each element in the pipeline to 
+// GST_Interface::applyAdaptiveLimits()
+static void adaptiveLimits(const GValue* item, gpointer data)
+{
+	GST_Interface* gstif = (GST_Interface*) data;
+	gstif->applyAdaptiveLimits(GST_ELEMENT(g_value_get_object(item)) );
+	
+	return;
+}
+
+// Callback Function: Pass each element in the pipeline to
+// GST_Interface::applyTuning()
+static void tuneElement(const GValue* item, gpointer data)
+{
+	GST_Interface* gstif = (GST_Interface*) data;
+	gstif->applyTuning(GST_ELEMENT(g_value_get_object(item)) );
+	
+	return;
+}
+
+// Callback Function: Pass each element in the pipeline to
+// GST_Interface::sampleSinkStats()
+static void qosSinkStats(const GValue* item, gpointer data)
+{
+	GST_Interface* gstif = (GST_Interface*) data;
+	gstif->sampleSinkStats(GST_ELEMENT(g_value_get_object(item)) );
+	
+	return;
+}
+
+// Callback Function: Switch a deinterlace element to a cheap method
+// deinterlacing only the top field if data points to true, restore the
+// method it had if false.  Other elements are ignored.
+static void degradeDeinterlace(const GValue* item, gpointer data)
+{
+	GstElement* element = GST_ELEMENT(g_value_get_object(item));
+	const bool on = *((const bool*) data);
+	
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory || QString(GST_OBJECT_NAME(factory)) != "deinterlace") return;
+	
+	if (on) {
+		gint method = 0;
+		g_object_get(G_OBJECT(element), "method", &method, NULL);
+		g_object_set_data(G_OBJECT(element), "mbmp-method", GINT_TO_POINTER(method + 1) );
+		g_object_set(G_OBJECT(element), "method", 4, "fields", 1, NULL);	// linear, top field
+	}
+	else {
+		const gint method = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(element), "mbmp-method") );
+		if (method > 0) g_object_set(G_OBJECT(element), "method", method - 1, NULL);
+		g_object_set(G_OBJECT(element), "fields", 0, NULL);
+	}
+	
+	return;
+}
+
+// Callback Function: Return 0 (a match) if the element in item is a video
+// sink doing its color balance in hardware.  Used with gst_iterator_find_custom()
+static gint findHardwareBalance(gconstpointer item, gconstpointer data)
+{
+	(void) data;
+	
+	GstElement* element = GST_ELEMENT(g_value_get_object((const GValue*) item));
+	if (GST_IS_BIN(element) || ! GST_IS_COLOR_BALANCE(element) || ! GST_OBJECT_FLAG_IS_SET(element, GST_ELEMENT_FLAG_SINK) ) return 1;
+	
+	return gst_color_balance_get_balance_type(GST_COLOR_BALANCE(element)) == GST_COLOR_BALANCE_HARDWARE ? 0 : 1;
+}
+
+// Callback Function: Count the frames the visualizer renders.  data is
+// the QAtomicInt to count in, read and reset by GST_Interface::checkQos()
+static GstPadProbeReturn countVisFrames(GstPad* pad, GstPadProbeInfo* info, gpointer data)
+{
+	(void) pad;
+	(void) info;
+	
+	static_cast<QAtomicInt*>(data)->ref();
+	return GST_PAD_PROBE_OK;
+}
+
+// Callback Function: Return 0 (a match) if the element in item is an
+// audio sink with a ring buffer.  Used with gst_iterator_find_custom()
+static gint findAudioSink(gconstpointer item, gconstpointer data)
+{
+	(void) data;
+	
+	GstElement* element = GST_ELEMENT(g_value_get_object((const GValue*) item));
+	return GST_IS_AUDIO_BASE_SINK(element) ? 0 : 1;
+}
+
+// Helper Function: Return "video" or "audio" for an element from its
+// factory klass, or an empty string if it is neither
+static QString qosMedia(GstElement* element)
+{
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory) return QString();
+	if (gst_element_factory_list_is_type(factory, GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO) ) return QString("video");
+	if (gst_element_factory_list_is_type(factory, GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO) ) return QString("audio");
+	
+	return QString();
+}
+
+// Callback Function: Order the decoders decodebin will try for caps by our
+// benchmark ranking.  Decoders we ranked come first, fastest first, then any
+// others.  Parsers and everything else that is not a decoder keep their
+// place in the list.  Return NULL to keep decodebin's order.
+static GValueArray* autoplugSort(GstElement* bin, GstPad* pad, GstCaps* caps, GValueArray* factories, gpointer data)
+{
+	(void) bin;
+	(void) pad;
+	
+	GST_Interface* gstif = (GST_Interface*) data;
+	if (gst_caps_get_size(caps) < 1) return NULL;
+	const QStringList ranking = gstif->decoderRanking(QString(gst_structure_get_name(gst_caps_get_structure(caps, 0))) );
+	if (ranking.isEmpty() ) return NULL;
+	
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	// decoders in the order we want them
+	QList<GValue*> decoders;
+	for (int i = 0; i < ranking.count(); ++i) {
+		for (guint j = 0; j < factories->n_values; ++j) {
+			GValue* v = g_value_array_get_nth(factories, j);
+			if (ranking.at(i) == QString(GST_OBJECT_NAME(g_value_get_object(v))) ) {
+				decoders.append(v);
+				break;
+			}
+		}	// for j
+	}	// for i
+	for (guint j = 0; j < factories->n_values; ++j) {
+		GValue* v = g_value_array_get_nth(factories, j);
+		if (gst_element_factory_list_is_type(GST_ELEMENT_FACTORY(g_value_get_object(v)), GST_ELEMENT_FACTORY_TYPE_DECODER) && ! decoders.contains(v) ) 
+			decoders.append(v);
+	}	// for j
+	
+	// rebuild the list, decoder slots are filled in our order
+	GValueArray* sorted = g_value_array_new(factories->n_values);
+	for (guint j = 0; j < factories->n_values; ++j) {
+		GValue* v = g_value_array_get_nth(factories, j);
+		if (gst_element_factory_list_is_type(GST_ELEMENT_FACTORY(g_value_get_object(v)), GST_ELEMENT_FACTORY_TYPE_DECODER) )
+			g_value_array_append(sorted, decoders.takeFirst() );
+		else
+			g_value_array_append(sorted, v);
+	}	// for j
+	G_GNUC_END_IGNORE_DEPRECATIONS
+	
+	return sorted;
+}
+
+// Callback Function: Watch for the caps event on a decoder sink pad and pass
+// the caps to GST_Interface::tuneDecoder() before the decoder opens, and to
+// GST_Interface::chooseVideoSink().  Called from a streaming thread.
+static GstPadProbeReturn decoderCapsProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data)
+{
+	GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+	if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) return GST_PAD_PROBE_OK;
+	
+	GstCaps* caps = NULL;
+	gst_event_parse_caps(event, &caps);
+	GstElement* decoder = gst_pad_get_parent_element(pad);
+	if (decoder) {
+		GST_Interface* gstif = (GST_Interface*) data;
+		gstif->tuneDecoder(decoder, caps);
+		gstif->chooseVideoSink(caps);
+		gst_object_unref(decoder);
+	}
+	
+	return GST_PAD_PROBE_OK;
+}
+
+// Callback Function: Wait for the first caps event on the src pad of a queue
+// or multiqueue task that had no caps yet when its thread entered.  The
+// event is pushed from that task's streaming thread, so pass the caps to
+// GST_Interface::threadCaps() from there.  Only the first caps are looked
+// at, the probe removes itself.
+static GstPadProbeReturn threadCapsProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data)
+{
+	GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+	if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) return GST_PAD_PROBE_OK;
+	
+	GstCaps* caps = NULL;
+	gst_event_parse_caps(event, &caps);
+	GST_Interface* gstif = (GST_Interface*) data;
+	gstif->threadCaps(pad, caps);
+	
+	return GST_PAD_PROBE_REMOVE;
+}
+
+// Callback Function: Pass each element in the pipeline to 
+// GST_Interface::applyDecoderLoad()
+static void decoderLoad(const GValue* item, gpointer data)
+{
+	GST_Interface* gstif = (GST_Interface*) data;
+	gstif->applyDecoderLoad(GST_ELEMENT(g_value_get_object(item)) );
+	
+	return;
+}
+
+// Callback Function: Pass elements added anywhere in the playbin on to
+// GST_Interface::elementAdded().  May be called from a streaming thread.
+static void deepElementAdded(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data)
+{
+	(void) bin;
+	(void) sub_bin;
+	
+	GST_Interface* gstif = (GST_Interface*) data;
+	gstif->elementAdded(element);
+	
+	return;
+}
+
+// Callback Function: uridecodebin gives its download queue2 a temp-template,
+// which puts the download cache in a file.  Clear it again so queue2 keeps
+// its ring buffer in memory.
+static void tempTemplateChanged(GObject* queue, GParamSpec* pspec, gpointer data)
+{
+	(void) pspec;
+	(void) data;
+	gchar* tmpl = NULL;
+	
+	g_object_get(queue, "temp-template", &tmpl, NULL);
+	if (tmpl != NULL) g_object_set(queue, "temp-template", NULL, NULL);
+	g_free(tmpl);
+	
+	return;
+}
+
+// Constants
+static const guint64 timeshift_bytes_per_min = 60 * 1024 * 1024;	// ring size for one minute of timeshift, 8 Mbit/s
+
 // Constructor
 GST_Interface::GST_Interface(QObject* parent) : QObject(parent)
 {
@@ -84,6 +442,54 @@ GST_Interface::GST_Interface(QObject* parent) : QObject(parent)
   mediatype = MBMP_GI::NoStream;  // the type of media playing
   is_live = false;            // true if we are playing a live stream
   is_buffering = false;       // true if we are currently buffering
+  dl_maximum = -1;            // largest download time estimate seen for this stream
+  ringbuffer_size = 0;        // download cache size in bytes, 0 keeps the whole file
+  ringbuffer_memory = false;  // true to keep the download cache in memory, not a temp file
+  bw_in = 0.0;                // smoothed network input rate in bytes/sec
+  bw_out = 0.0;               // smoothed playback consumption rate in bytes/sec
+  bw_applied = 0;             // connection-speed (kbps) last given to playbin
+  buffer_time = -1;           // stream buffer duration in ns, -1 is the playbin default
+  buffer_high = 0.0;          // high watermark last applied
+  stall_level = 0;            // number of recent early rebuffers
+  video_area = QSize();       // size of the video window in pixels
+  video_visible = true;       // false if the video window can't be seen
+  adaptive_bw = 0;            // bandwidth (kbps) measured from adaptive stream fragments
+  variant_kbps = 0;           // bitrate (kbps) of the adaptive stream variant playing
+  decoder_loaded = false;     // true if decoders are skipping frames to keep up
+  sink_bin = NULL;            // video-sink bin holding the per codec sink, owned by playbin
+  sink_chosen = false;        // true once the sink in sink_bin is picked for this media
+  tuning = 0;                 // index of the tuning profile in tuning_profiles[]
+  tuning_flags = 0;           // buffering flags as they were under the default profile
+  qos_alert = false;          // true if the video QoS is over the threshold
+  degrade_enabled = false;    // true to degrade quality under QoS pressure
+  degrade_level = 0;          // degradation steps taken
+  degrade_taken = 0;          // bit n set if step n was really applied
+  degrade_wait = 0;           // QoS windows since the last step
+  degrade_calm = 0;           // QoS windows in a row under the threshold
+  vis_factory = NULL;         // visualizer selected, NULL is the playbin default
+  scale_caps = NULL;          // capsfilter of the downscaling video-filter
+  window_scaling = false;     // true to scale video down to the window size before the sink
+  vis_caps = NULL;            // capsfilter after the visualizer
+  vis_fps = 0;                // visualizer framerate cap, 0 for none
+  vis_size = QSize();         // visualizer size, invalid to follow the video window
+  vis_frames.store(0);        // frames rendered by the visualizer this QoS window
+  audio_sink.clear();         // audio sink to use, empty is the playbin default
+  audio_sink_set = false;     // true once audio_sink is given to playbin
+  audio_buffer = 0;           // audio sink buffer-time in us, 0 uses the tuning profile
+  audio_latency = 0;          // audio sink latency-time in us, 0 uses the tuning profile
+  audio_only = false;         // true if the next media is known to be audio only
+  fastpath_flags = 0;         // play flags the audio-only fast path has cleared
+  hidden_flags = 0;           // play flags cleared while the video of a URL stream is hidden
+  hidden_decoding = false;    // true if only keyframes are decoded because the video is hidden
+  render_rect = QRect();      // where in the video window the sink draws, empty for all of it
+  ts_queue.store(NULL);       // queue2 holding the timeshift ring buffer, NULL if not timeshifting
+  ts_bytes = 0;               // size of the timeshift ring buffer in bytes, 0 for no timeshift
+  ts_secs = 0;                // most seconds we may shift back, 0 for as far as the ring goes
+  ts_base = 0;                // stream position (ns) when the timeshift clock started
+  ts_clock.invalidate();      // running since ts_base, the live edge moves with it
+  thread_policy = -1;         // scheduling policy for audio threads, -1 leaves them alone
+  thread_cpus.clear();        // CPUs to pin audio threads to, empty for any
+  qos_stats.clear();
   vismap.clear();
   streammap.clear();
   opticaldrive.clear();
@@ -94,6 +500,27 @@ GST_Interface::GST_Interface(QObject* parent) : QObject(parent)
   // setup the dialog to display stream info
   streaminfo = new StreamInfo(this);
   streaminfo->enableAll(false);
+  
+  // the color balance dialog, no adjustment to start
+  colorbalance = new ColorBalance(this);
+  balance["brightness"] = 0;
+  balance["contrast"] = 0;
+  balance["hue"] = 0;
+  balance["saturation"] = 0;
+  balance_touched = false;
+  
+  // the tracer profiler, reports go straight to the dialog
+  profiler = new PipelineProfiler(this);
+  connect(profiler, SIGNAL(reportReady(QString)), streaminfo, SLOT(updateProfileBox(QString)));
+  
+  // the persistent cache for remote media files, off until given a size
+  mediacache = new MediaCache(this);
+  connect(mediacache, SIGNAL(message(QString)), this, SLOT(cacheMessage(QString)));
+  
+  // record while playing, off until toggled
+  recorder = new StreamRecorder(this);
+  connect(recorder, SIGNAL(finished(QString, bool, QString)), this, SLOT(recordingFinished(QString, bool, QString)));
+  record_dir.clear();
     
   // initialize gstreamer
   gst_init(NULL, NULL);
@@ -101,18 +528,32 @@ GST_Interface::GST_Interface(QObject* parent) : QObject(parent)
   // Create the playbin pipeline, call it PLAYER_NAME defined in resource.h
   pipeline_playbin = gst_element_factory_make("playbin", PLAYER_NAME);
   
+  // playbin puts a software videobalance in by default, only want that
+  // when the color balance is adjusted and the sink can't do it
+  setPlayFlag(GST_PLAY_FLAG_SOFT_COLORBALANCE, false);
+  
   // Create the playbin bus and add a watch
   GstBus* bus;
   bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline_playbin));
   gst_bus_add_watch(bus, busCallback, this);
+  gst_bus_set_sync_handler(bus, busSyncHandler, this, NULL);
   gst_object_unref (bus);
   
   // Monitor the playbin source-setup signal
   g_signal_connect (GST_ELEMENT(pipeline_playbin), "source-setup", G_CALLBACK (&sourceSetup), &opticaldrive);
   
+  // Monitor elements as the playbin creates them
+  g_signal_connect (GST_ELEMENT(pipeline_playbin), "deep-element-added", G_CALLBACK (&deepElementAdded), this);
+  
   // Create the timers we need and connect them to slots  
   dl_timer = new QTimer(this);
   connect(dl_timer, SIGNAL(timeout()), this, SLOT(downloadBuffer()));
+  qos_timer = new QTimer(this);
+  connect(qos_timer, SIGNAL(timeout()), this, SLOT(checkQos()));
+  hide_timer = new QTimer(this);
+  hide_timer->setSingleShot(true);
+  hide_timer->setInterval(hide_delay);
+  connect(hide_timer, SIGNAL(timeout()), this, SLOT(hideTimeout()));
     
   // Create a QMap of the available audio visualizers.  Map format is
   // QString key
@@ -120,6 +561,11 @@ GST_Interface::GST_Interface(QObject* parent) : QObject(parent)
   GList* vis_list;
   GList* walk;
  
+  // Register our own spectrum visualizer first so it is found along with
+  // the visualizers from the installed plugins.
+  if (! mbmp_spectrum_register() )
+    qDebug() << "Could not register the mbmpspectrum visualizer";
+  
   // Get a list of all visualization plugins.  Use the helper function
   // filter_features() at the top of this file.
   vis_list = gst_registry_feature_filter (gst_registry_get(), filter_features, FALSE, (gchar*)"Visualization");
@@ -193,7 +639,11 @@ GST_Interface::GST_Interface(QObject* parent) : QObject(parent)
 // Destructor
 GST_Interface::~GST_Interface()
 {
+  recorder->stop();
   gst_element_set_state (pipeline_playbin, GST_STATE_NULL);
+  clearTimeshift();
+  if (scale_caps) gst_object_unref (GST_OBJECT (scale_caps));
+  if (vis_caps) gst_object_unref (GST_OBJECT (vis_caps));
   gst_object_unref (GST_OBJECT (pipeline_playbin));
   
 }
@@ -412,22 +862,123 @@ void GST_Interface::playMedia(WId winId, QString uri, int track)
     // variables
     GstStateChangeReturn ret;
     
-    // start with the pipeline_playbin set to NULL, is_live to false
+    // start with the pipeline_playbin set to NULL, is_live to false.  A
+    // recording is of one stream only, finish it first.
+    stopRecording();
     gst_element_set_state (pipeline_playbin, GST_STATE_NULL);
     is_live = false;
+    is_buffering = false;
+    clearTimeshift();
+    
+    // the video sinks the benchmark found fastest are per codec, and the
+    // codec is not known yet.  Give playbin a bin holding autovideosink,
+    // chooseVideoSink() swaps in the sink for the codec once the video
+    // decoder has caps.  video-sink can only be changed in the NULL or
+    // READY states, the bin is kept for the next media.
+    ranking_mutex.lock();
+    sink_chosen = false;
+    if (! codec_sinks.isEmpty() && ! sink_bin) {
+      sink_bin = gst_bin_new("mbmp_video_sink");
+      GstElement* vsink = gst_element_factory_make("autovideosink", "mbmp_sink");
+      GstPad* pad = vsink ? gst_element_get_static_pad(vsink, "sink") : NULL;
+      if (pad) {
+        gst_bin_add(GST_BIN(sink_bin), vsink);
+        gst_element_add_pad(sink_bin, gst_ghost_pad_new("sink", pad) );
+        gst_object_unref(pad);
+        g_object_set(G_OBJECT(pipeline_playbin), "video-sink", sink_bin, NULL);
+      }
+      else {
+        if (vsink) gst_object_unref(GST_OBJECT(vsink));
+        gst_object_unref(GST_OBJECT(sink_bin));
+        sink_bin = NULL;
+      }
+    }	// if codec_sinks
+    ranking_mutex.unlock();
+    
+    // the audio sink we were told to use, same rule as the video sink.
+    // With a buffer set hand volume to the sink, but only if it has a
+    // volume property of its own, otherwise it would not be heard at all.
+    if (! audio_sink.isEmpty() && ! audio_sink_set) {
+      GstElement* asink = gst_element_factory_make(qPrintable(audio_sink), NULL);
+      if (asink) {
+        g_object_set(G_OBJECT(pipeline_playbin), "audio-sink", asink, NULL);
+        if (audio_buffer > 0 && g_object_class_find_property(G_OBJECT_GET_CLASS(asink), "volume") )
+          setPlayFlag(GST_PLAY_FLAG_SOFT_VOLUME, false);
+      }
+      else
+        emit signalMessage(MBMP_GI::Warning, QString(tr("Audio sink %1 is not available, using the default")).arg(audio_sink) );
+      audio_sink_set = true;
+    }	// if audio_sink
+    
+    // audio-only fast path.  Give back the flags taken for the last stream,
+    // then if the discoverer found only audio (or this is an audio CD) drop
+    // the video and subtitle chains so playbin builds the minimal pipeline.
+    // The visualizer needs the video chain so leave it alone if that is on.
+    // The hint is good for this stream only.
+    restoreFastPath();
+    if ((audio_only || uri.startsWith("cdda://", Qt::CaseInsensitive)) && ! checkPlayFlag(GST_PLAY_FLAG_VIS) ) {
+      guint flags = 0;
+      g_object_get (pipeline_playbin, "flags", &flags, NULL);
+      fastpath_flags = flags & (GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_TEXT);
+      if (fastpath_flags) {
+        g_object_set (pipeline_playbin, "flags", flags & ~fastpath_flags, NULL);
+        emit signalMessage(MBMP_GI::Application, tr("Audio only media, not building the video and subtitle chains") );
+      }
+    }	// if audio_only
+    audio_only = false;
+    hidden_decoding = false;
+    hide_timer->stop();
+    
+    dl_maximum = -1;
+    dl_timer->stop();
+    
+    // the throughput estimate belongs to the connection so keep it, but
+    // start the new stream without the stall history of the old one
+    stall_level = 0;
+    resume_timer.invalidate();
+    if (bw_in > 0.0) tuneBuffering();
+    variant_kbps = 0;
+    streaminfo->updateNetworkBox(tr("Network Information"));
+    decoder_loaded = false;
+    
+    // profiles are per stream
+    if (profiler->isActive() ) profiler->clear();
+    
+    // QoS statistics and degradation are per stream
+    if (degrade_level > 0) setDegradeLevel(0);
+    qos_stats.clear();
+    if (qos_alert) emit qosThreshold(false);
+    qos_alert = false;
+    streaminfo->updateQosBox(tr("QoS Statistics"));
+    qos_timer->start(qos_interval);
+    
+    // the scaling caps are for the last stream, open them up until the
+    // new one is playing
+    if (scale_caps) {
+      GstCaps* caps = gst_caps_new_any();
+      g_object_set(G_OBJECT(scale_caps), "caps", caps, NULL);
+      gst_caps_unref(caps);
+    }
   
-    // Set the media source. 
-    g_object_set(G_OBJECT(pipeline_playbin), "uri", qPrintable(uri), NULL);    
+    // software color balance only if there is something to adjust, playbin
+    // won't use it anyway if the sink has hardware color balance
+    setPlayFlag(GST_PLAY_FLAG_SOFT_COLORBALANCE, ! balanceNeutral() );
+  
+    // Set the media source.  Remote files are read through the media cache
+    // if it is on.
+    g_object_set(G_OBJECT(pipeline_playbin), "uri", qPrintable(mediacache->localUri(uri)), NULL);    
     
     // Set our media type variable
     if (uri.startsWith("cdda://", Qt::CaseInsensitive)) mediatype = MBMP_GI::ACD;
     else if (uri.startsWith("dvd://", Qt::CaseInsensitive)) mediatype = MBMP_GI::DVD;
-      else if (uri.startsWith("http://", Qt::CaseInsensitive) || uri.startsWith("ftp://", Qt::CaseInsensitive)) mediatype = MBMP_GI::Url;
+      else if (uri.startsWith("http://", Qt::CaseInsensitive) || uri.startsWith("https://", Qt::CaseInsensitive) || uri.startsWith("ftp://", Qt::CaseInsensitive)) mediatype = MBMP_GI::Url;
         else  mediatype = MBMP_GI::File;
 
     // Set the video overlay and allow it to handle navigation events
     gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(pipeline_playbin), winId);
     gst_video_overlay_handle_events(GST_VIDEO_OVERLAY(pipeline_playbin), TRUE);                
+    if (render_rect.isValid() )
+      gst_video_overlay_set_render_rectangle(GST_VIDEO_OVERLAY(pipeline_playbin), render_rect.x(), render_rect.y(), render_rect.width(), render_rect.height() );
 
     // Bring the pipeline to paused and see if we have a live stream (for buffering)
     ret = gst_element_set_state(pipeline_playbin, GST_STATE_PAUSED);
@@ -528,8 +1079,10 @@ void GST_Interface::changeVisualizer(const QString& vis)
     return ;
   } // if
   
-  // We have now selected a factory for the visualization element 
-  vis_plugin = gst_element_factory_create (selected_factory, NULL);
+  // We have now selected a factory for the visualization element, it
+  // gets our framerate and size caps
+  vis_factory = selected_factory;
+  vis_plugin = makeVisualizer(selected_factory);
   if (!vis_plugin) vis_plugin = NULL; // if null use the default
   
   //set the vis plugin for our pipeline_playbin
@@ -559,7 +1112,10 @@ void GST_Interface::setPlayFlag (const guint& targetflag, const bool& b)
   guint flags = 0;
   g_object_get (pipeline_playbin, "flags", &flags, NULL);
   
-  // now do the setting or unsetting
+  // now do the setting or unsetting.  An explicit setting wins over the
+  // audio-only fast path so don't restore this flag later.
+  fastpath_flags &= ~targetflag;
+  hidden_flags &= ~targetflag;
   b ? flags |= targetflag : flags &= ~targetflag;
   g_object_set (pipeline_playbin, "flags", flags, NULL);  
 }
@@ -699,6 +1255,8 @@ gint64 GST_Interface::queryDuration(GstFormat fmt)
 	
 	if (getState() == GST_STATE_PLAYING) {
 		if (!gst_element_query_duration (pipeline_playbin, fmt, &duration)) {
+			// a timeshifted live stream lasts up to the live edge
+			if (fmt == GST_FORMAT_TIME && isTimeshifting() && ts_clock.isValid() ) return timeshiftLiveEdge();
 			emit signalMessage(MBMP_GI::Info, tr("Info: Could not query the stream duration with GstFormat: %1").arg(gst_format_get_name(fmt)) );    
 		}	// if query
 	}	// if playing
@@ -716,6 +1274,20 @@ bool GST_Interface::queryStreamSeek()
   // Make sure we are playing
   if (getState() != GST_STATE_PLAYING ) return false;
   
+  // a timeshifted stream seeks in our ring buffer, ask the queue2 holding
+  // it, in bytes which is all it answers for
+  GstElement* tsq = ts_queue.load();
+  if (tsq) {
+    gboolean ts_seekable = FALSE;
+    GstPad* pad = gst_element_get_static_pad(tsq, "src");
+    GstQuery* tsquery = gst_query_new_seeking (GST_FORMAT_BYTES);
+    if (pad && gst_pad_query (pad, tsquery) )
+      gst_query_parse_seeking (tsquery, NULL, &ts_seekable, NULL, NULL);
+    gst_query_unref (tsquery);
+    if (pad) gst_object_unref(pad);
+    return static_cast<bool>(ts_seekable);
+  }	// if timeshifting
+  
   // Variables
   GstQuery* query = 0;
   gint64 start = 0; // for now we don't do anything with start and end
@@ -848,6 +1420,13 @@ gint64 GST_Interface::queryStreamPosition()
 						streaminfo->setComboBoxes(streammap); 
 						streaminfo->setSubtitleBoxEnabled(checkPlayFlag(GST_PLAY_FLAG_TEXT));
 						streaminfo->enableAll(true);
+						if (! video_visible) hide_timer->start();
+						updateScaleCaps();
+						applyColorBalance();
+						if (isTimeshifting() && ! ts_clock.isValid() ) {
+							ts_base = queryStreamPosition();
+							ts_clock.start();
+						}
 						break;
 					case GST_STATE_PAUSED:
 						streaminfo->enableAll(false);
@@ -859,7 +1438,10 @@ gint64 GST_Interface::queryStreamPosition()
 					  mediatype = MBMP_GI::NoStream;  
 					  is_live = false;
 					  is_buffering = false;
+					  dl_maximum = -1;
 					  dl_timer->stop();
+					  hidden_decoding = false;
+					  hide_timer->stop();
 						break;	
 					default:
 						streaminfo->updateAudioBox(tr("Audio Information"));
@@ -885,25 +1467,40 @@ gint64 GST_Interface::queryStreamPosition()
 			// if a live stream don't buffer
 			if (is_live) break;           
 							
-			// if download flag is set report buffering and let ASYNC_DONE deal with buffering
+			// If the download flag is set the buffering percent is only the fill
+			// level of the download cache so ignore it.  Pause only when the download
+			// can't keep up with playback, downloadBuffer() restarts playback as soon
+			// as the estimated download rate will sustain it.
 			guint flags = 0;
 			g_object_get (pipeline_playbin, "flags", &flags, NULL);
 			if (  (flags & GST_PLAY_FLAG_DOWNLOAD) ) {
-				is_buffering = true;
+				if (! dl_timer->isActive() && ! downloadSustainable() ) {
+					gst_element_set_state (pipeline_playbin, GST_STATE_PAUSED);
+					is_buffering = true;
+					dl_timer->start(500);
+				}
 				break;
 			} 
 			
-			// non-download buffering
+			// Non-download buffering.  Queues report < 100% once they drain
+			// to the low watermark and 100% when they refill to the high
+			// watermark, the gap between the two is our hysteresis.  A stall
+			// soon after resuming means the buffer is too small for the
+			// connection so grow it before pausing.
 			gint percent = 0;
 			gst_message_parse_buffering(msg, &percent);
+			updateThroughput(msg);
 			
 			if (percent < 100) {
 				if (! is_buffering) {
+					if (resume_timer.isValid() && resume_timer.elapsed() < stall_window && stall_level < max_stall_level) ++stall_level;
+					tuneBuffering();
 					gst_element_set_state (pipeline_playbin, GST_STATE_PAUSED);
 					is_buffering = true;
 				}
 			}
 			else {
+				if (is_buffering) resume_timer.start();
 				gst_element_set_state (pipeline_playbin, GST_STATE_PLAYING);
 				is_buffering = false;
 			}
@@ -1109,6 +1706,26 @@ gint64 GST_Interface::queryStreamPosition()
 			emit signalMessage(MBMP_GI::StreamStatus, QString(tr("Stream Status: %1").arg(s)) );
 			break; } // GST_STREAM_STATUS case
 		
+		// Quality of service message, posted when an element (usually a sink) is
+		// late with or drops buffers.  Only added to the statistics of that
+		// element here, checkQos() looks at them every qos_interval and decides
+		// whether to raise the alert or take a degradation step.
+		case GST_MESSAGE_QOS:
+			updateQos(msg);
+			break;
+		
+		// Element messages.  The adaptive demuxers (HLS, DASH, MSS) post statistics
+		// for every fragment they download, use them to measure the bandwidth
+		// and to follow the variant being played.
+		case GST_MESSAGE_ELEMENT: {
+			const GstStructure* s = gst_message_get_structure (msg);
+			if (s && gst_structure_has_name (s, "adaptive-streaming-statistics") ) {
+				updateAdaptiveStats(s);
+				break;
+			}
+			emit signalMessage(MBMP_GI::Unhandled, QString(tr("Unhandled GSTBUS message: %1")).arg(QString(gst_message_type_get_name(GST_MESSAGE_TYPE (msg)))) );
+			break; } // GST_MESSAGE_ELEMENT case
+		
 		default:
 		QString type = QString(gst_message_type_get_name(GST_MESSAGE_TYPE (msg)) );
 			emit signalMessage(MBMP_GI::Unhandled, QString(tr("Unhandled GSTBUS message: %1")).arg(type) );
@@ -1118,110 +1735,964 @@ gint64 GST_Interface::queryStreamPosition()
   return;
 }
 
-//////////////////////////// Public Slots ////////////////////////////
 //
-// Slot to process a mouse navigation event.  Our VideoWidget emits a signal
-// (via PlayerCtl) containing the mouse event data. The signal is connected
-// to this function which then injects the mouse event into the stream
-void GST_Interface::mouseNavEvent(QString event, int button, int x, int y)
+// Function to set the priority and CPU affinity of a streaming thread that
+// belongs to the audio path.  Called from busSyncHandler() for every stream
+// status message, in the thread that posted it, so only ENTER messages are
+// acted on (they come from the new thread itself) and the GUI is never
+// touched.  Audio threads are the audio sink ring buffer thread and the
+// tasks of audio elements or pads with audio caps.  Queue and multiqueue
+// src pad tasks have no caps yet at ENTER, for those a probe waits for the
+// first caps event and threadCaps() decides from inside the same thread.
+void GST_Interface::threadEntered(GstMessage* msg)
 {
-  // Do nothing if we are not playing 
-  if (getState() != GST_STATE_PLAYING)  return;
-    
-  // Find the gstNavigation element (part of xvimagesink)
-  GstNavigation* nav = 0;           
-  nav = GST_NAVIGATION (pipeline_playbin);
-  
-  // Return if we could not find a GstNavigation element in the pipeline
-  if (! nav) return;
-  
-  // Inject the mouse event data into the stream
-  gst_navigation_send_mouse_event(nav, qPrintable(event), button, static_cast<double>(x), static_cast<double>(y));
-  
-  return;
+	if (thread_policy < 0 && thread_cpus.isEmpty() ) return;
+	
+	GstStreamStatusType type;
+	GstElement* owner = NULL;
+	gst_message_parse_stream_status (msg, &type, &owner);
+	if (type != GST_STREAM_STATUS_TYPE_ENTER || ! owner) return;
+	
+	// decide if this is an audio thread
+	bool audio = GST_IS_AUDIO_BASE_SINK(owner);
+	if (! audio) {
+		GstElementFactory* factory = gst_element_get_factory(owner);
+		if (factory) {
+			const gchar* klass = gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+			audio = klass && strstr(klass, "Audio") && ! strstr(klass, "Video");
+		}
+	}
+	if (! audio && GST_IS_PAD(GST_MESSAGE_SRC(msg)) ) {
+		GstPad* pad = GST_PAD(GST_MESSAGE_SRC(msg));
+		GstCaps* caps = gst_pad_get_current_caps(pad);
+		if (caps) {
+			audio = g_str_has_prefix(gst_structure_get_name(gst_caps_get_structure(caps, 0)), "audio/");
+			gst_caps_unref(caps);
+		}
+		else if (GST_PAD_IS_SRC(pad) ) {
+			gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, threadCapsProbe, this, NULL);
+			return;
+		}
+	}
+	if (! audio) return;
+	
+	boostThread(QString(GST_OBJECT_NAME(GST_MESSAGE_SRC(msg))), QString(GST_OBJECT_NAME(owner)) );
+	
+	return;
 }
 
 //
-//  Slot to process a key navigation event
-void GST_Interface::keyNavEvent(GstNavigationCommand cmd)
+// Function to look at the first caps of a pad task that had none when its
+// thread entered.  Called from threadCapsProbe() in that task's streaming
+// thread, if the caps are audio the thread gets the audio thread policy.
+void GST_Interface::threadCaps(GstPad* pad, GstCaps* caps)
 {
-  // Do nothing if we are not playing 
-  if (getState() != GST_STATE_PLAYING)  return;
-  
-  // Find the gstNavigation element (part of xvimagesink)
-  GstNavigation* nav = 0;           
-  nav = GST_NAVIGATION (pipeline_playbin);  
-  
-  // Return if we could not find a GstNavigation element in the pipeline
-  if (! nav) return;  
-  
-  // Inject the command into the stream
-  gst_navigation_send_command(nav, cmd);
-  
-  return;
+	if (thread_policy < 0 && thread_cpus.isEmpty() ) return;
+	if (! caps || gst_caps_is_empty(caps) || gst_caps_is_any(caps) ) return;
+	if (! g_str_has_prefix(gst_structure_get_name(gst_caps_get_structure(caps, 0)), "audio/") ) return;
+	
+	GstElement* owner = gst_pad_get_parent_element(pad);
+	boostThread(QString(GST_OBJECT_NAME(pad)), owner ? QString(GST_OBJECT_NAME(owner)) : QString() );
+	if (owner) gst_object_unref(owner);
+	
+	return;
 }
 
 //
-// Slot to seek to a specific position in the stream. Seek position
-// sent is in seconds so need to convert it to nanoseconds for gstreamer
-// Called when a QAction is triggered
-void GST_Interface::seekToPosition(int position)
+// Function to apply the audio thread policy to the calling thread, name and
+// owner only label the log message.  Real-time scheduling needs
+// CAP_SYS_NICE or an RLIMIT_RTPRIO, without it fall back to a nice boost
+// which needs RLIMIT_NICE.  Every assignment, or the reason it could not be
+// made, is logged.
+void GST_Interface::boostThread(const QString& name, const QString& owner)
 {
-  // return if seeking is not enabled
-  if (! this->queryStreamSeek() ) return;
-  
-  // seek flags
-  const int seekflags =  GST_SEEK_FLAG_FLUSH    | // flush the pipeline_playbin
-                          GST_SEEK_FLAG_SKIP     | // allow skipping frames
-                          GST_SEEK_FLAG_KEY_UNIT ; // seek to the nearest keyframe, faster but maybe not as accurate
-                         	 
-  // now do the seek
-  gst_element_seek_simple(pipeline_playbin, GST_FORMAT_TIME, (GstSeekFlags)(seekflags) , position * GST_SECOND);
-  return;
-} 
+	const long tid = syscall(SYS_gettid);
+	QStringList done;
+	
+	// scheduling
+	bool try_nice = (thread_policy == SCHED_OTHER);
+	if (thread_policy == SCHED_FIFO || thread_policy == SCHED_RR) {
+		struct sched_param sp;
+		sp.sched_priority = qMin(sched_get_priority_min(thread_policy) + 10, sched_get_priority_max(thread_policy));
+		const int rtn = pthread_setschedparam(pthread_self(), thread_policy, &sp);
+		if (rtn == 0)
+			done << QString(tr("%1 priority %2")).arg(thread_policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR").arg(sp.sched_priority);
+		else {
+			done << QString(tr("real-time scheduling refused (%1)")).arg(strerror(rtn));
+			try_nice = true;
+		}
+	}
+	if (try_nice) {
+		if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), -10) == 0)
+			done << tr("nice -10");
+		else
+			done << QString(tr("nice boost refused (%1)")).arg(strerror(errno));
+	}
+	
+	// affinity
+	if (! thread_cpus.isEmpty() ) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		QStringList sl;
+		for (int i = 0; i < thread_cpus.count(); ++i) {
+			CPU_SET(thread_cpus.at(i), &set);
+			sl << QString::number(thread_cpus.at(i));
+		}
+		const int rtn = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+		if (rtn == 0)
+			done << QString(tr("pinned to CPU %1")).arg(sl.join(","));
+		else
+			done << QString(tr("pinning refused (%1)")).arg(strerror(rtn));
+	}
+	
+	// queued to the GUI thread since we are in a streaming thread
+	emit signalMessage(MBMP_GI::Application, QString(tr("Audio thread %1 (%2, tid %3): %4"))
+		.arg(name)
+		.arg(owner)
+		.arg(tid)
+		.arg(done.join(", ")) );
+	
+	return;
+}
 
+//
+// Function to configure elements as they are added to the playbin.  Called
+// from the deepElementAdded() callback, often from a streaming thread, so
+// only read our settings here and never touch the GUI.
+void GST_Interface::elementAdded(GstElement* element)
+{
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory) return;
+	const QString name = QString(GST_OBJECT_NAME(factory));
+	
+	// download cache in memory instead of a temp file.  uridecodebin sets
+	// the temp-template before it adds the queue2, so clear one already
+	// there as well as any set later.
+	if (name == "queue2" && ringbuffer_memory && ringbuffer_size > 0) {
+		tempTemplateChanged(G_OBJECT(element), NULL, NULL);
+		g_signal_connect (element, "notify::temp-template", G_CALLBACK (&tempTemplateChanged), NULL);
+	}
+	
+	// the stream buffering queue2 of a network stream, turn it into the
+	// timeshift ring buffer.  With a temp file queue2 keeps downloading while
+	// we are paused and serves seeks inside the ring itself.  If the download
+	// cache is kept in memory the handler above clears the temp-template and
+	// the ring is in memory too.
+	if (name == "queue2" && ts_bytes > 0 && mediatype == MBMP_GI::Url && ts_queue.load() == NULL) {
+		GstObject* parent = GST_OBJECT_PARENT(element);
+		GstElementFactory* pf = (parent && GST_IS_ELEMENT(parent)) ? gst_element_get_factory(GST_ELEMENT(parent)) : NULL;
+		if (pf && (QString(GST_OBJECT_NAME(pf)) == "uridecodebin" || QString(GST_OBJECT_NAME(pf)) == "urisourcebin") ) {
+			QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+			QDir dir(QString(env.value("XDG_CACHE_HOME", QString(QDir::homePath()) + "/.cache") + "/%1/timeshift").arg(QString(APP).toLower()) );
+			if (! dir.exists() ) dir.mkpath(dir.absolutePath() );
+			g_object_set(G_OBJECT(element),
+				"temp-template", qPrintable(dir.absoluteFilePath("mbmp-XXXXXX")),
+				"temp-remove", TRUE,
+				"ring-buffer-max-size", ts_bytes,
+				NULL);
+			ts_queue.store(GST_ELEMENT(gst_object_ref(element)) );
+			emit signalMessage(MBMP_GI::Application, QString(tr("Timeshift: recording the stream into a %1 MB ring buffer")).arg(ts_bytes / (1024 * 1024)) );
+		}	// if buffering queue
+	}	// if timeshift
+	
+	// adaptive stream demuxer, start it with our variant limits
+	applyAdaptiveLimits(element);
+	
+	// decodebin queues and audio sinks, from the tuning profile
+	applyTuning(element);
+	
+	// decodebin, let it try decoders in our benchmark order
+	if (name == "decodebin") {
+		g_signal_connect (element, "autoplug-sort", G_CALLBACK (&autoplugSort), this);
+	}
+	
+	// decoder, tune it from our profiles once we know what it will decode
+	if (gst_element_factory_list_is_type(factory, GST_ELEMENT_FACTORY_TYPE_DECODER) ) {
+		GstPad* pad = gst_element_get_static_pad(element, "sink");
+		if (pad) {
+			gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, decoderCapsProbe, this, NULL);
+			gst_object_unref(pad);
+		}
+	}	// if decoder
+	
+	return;
+}
 
 //
-// Slot to change the audio stream to the stream number sent
-void GST_Interface::setAudioStream(const int& stream)
+// Function to return the decoders for a codec (caps name) our benchmark
+// found, fastest first.  Called from streaming threads through the
+// autoplugSort() callback.
+QStringList GST_Interface::decoderRanking(const QString& codec)
 {
-  // make sure the stream exists
-  if (stream < 0 || stream >= (streammap["n-audio"]) ) return;
-      
-  // change the stream to the int sent to the function
-  g_object_set (G_OBJECT (pipeline_playbin), "current-audio", stream, NULL);
-    
-  // update the streammap and then the text display boxes
-  streammap["current-audio"] = stream;
-  streaminfo->updateAudioBox(getAudioStreamInfo());
-    
-  return;
-} 
+	QMutexLocker locker(&ranking_mutex);
+	
+	return dec_ranking.value(codec);
+}
 
 //
-// Slot to change the video stream to the stream number sent
-void GST_Interface::setVideoStream(const int& stream)
+// Function to put the video sink our benchmark found fastest for a codec
+// into sink_bin.  Called from the decoderCapsProbe() callback in a
+// streaming thread when a decoder receives caps.  Playbin only builds its
+// video chain once the decoders have output caps, so the sink in the bin is
+// not in use yet and can be swapped.  The first video decoder after
+// playMedia() decides, codecs without a ranking keep autovideosink.
+void GST_Interface::chooseVideoSink(GstCaps* caps)
 {
-  // make sure the stream exists
-  if (stream < 0 || stream >= (streammap["n-video"]) ) return;
-      
-  // change the stream to the int sent to the function
-  g_object_set (G_OBJECT (pipeline_playbin), "current-video", stream, NULL);
-    
-  // update the streammap and text display boxes
-  streammap["current-video"] = stream;
-  streaminfo->updateVideoBox(getVideoStreamInfo());
-  
-  return;
-} 
+	if (! caps || gst_caps_get_size(caps) < 1) return;
+	const QString codec = QString(gst_structure_get_name(gst_caps_get_structure(caps, 0)) );
+	if (! codec.startsWith("video/") ) return;
+	
+	QMutexLocker locker(&ranking_mutex);
+	if (! sink_bin || sink_chosen) return;
+	sink_chosen = true;
+	
+	const QString name = codec_sinks.value(codec, QString("autovideosink") );
+	GstElement* old = gst_bin_get_by_name(GST_BIN(sink_bin), "mbmp_sink");
+	if (! old) return;
+	GstElementFactory* factory = gst_element_get_factory(old);
+	if ((factory && QString(GST_OBJECT_NAME(factory)) == name) || GST_STATE(old) > GST_STATE_READY) {
+		gst_object_unref(old);
+		return;
+	}
+	
+	GstElement* vsink = gst_element_factory_make(qPrintable(name), NULL);
+	GstPad* pad = vsink ? gst_element_get_static_pad(vsink, "sink") : NULL;
+	if (! pad) {
+		if (vsink) gst_object_unref(GST_OBJECT(vsink));
+		gst_object_unref(old);
+		emit signalMessage(MBMP_GI::Application, QString(tr("Video sink %1 for %2 could not be created")).arg(name).arg(codec) );
+		return;
+	}
+	
+	gst_element_set_state(old, GST_STATE_NULL);
+	gst_bin_remove(GST_BIN(sink_bin), old);
+	gst_object_unref(old);
+	gst_object_set_name(GST_OBJECT(vsink), "mbmp_sink");
+	gst_bin_add(GST_BIN(sink_bin), vsink);
+	GstPad* ghost = gst_element_get_static_pad(sink_bin, "sink");
+	gst_ghost_pad_set_target(GST_GHOST_PAD(ghost), pad);
+	gst_object_unref(ghost);
+	gst_object_unref(pad);
+	gst_element_sync_state_with_parent(vsink);
+	emit signalMessage(MBMP_GI::Application, QString(tr("Using video sink %1 for %2")).arg(name).arg(codec) );
+	
+	return;
+}
 
 //
-// Slot to change the subtitle stream to the stream number sent
-void GST_Interface::setTextStream(const int& stream)
+// Function to apply the matching DecoderProfile to a decoder.  Called from
+// the decoderCapsProbe() callback in a streaming thread when the decoder
+// receives caps, before it opens, so threading settings take effect.
+// Properties the decoder does not have are skipped.
+void GST_Interface::tuneDecoder(GstElement* decoder, GstCaps* caps)
 {
-  // make sure the stream exists
-  if (stream < 0 || stream >= (streammap["n-text"]) ) return;
-  
+	GstElementFactory* factory = gst_element_get_factory(decoder);
+	if (! factory || ! caps || gst_caps_get_size(caps) < 1) return;
+	
+	const GstStructure* s = gst_caps_get_structure(caps, 0);
+	const QString media = QString(gst_structure_get_name(s)).section('/', 0, 0);
+	gint height = 0;
+	gst_structure_get_int(s, "height", &height);
+	
+	DecoderProfile p;
+	const QString name = QString(GST_OBJECT_NAME(factory));
+	if (! findDecoderProfile(name, media, height, p) ) return;
+	
+	GObjectClass* klass = G_OBJECT_GET_CLASS(decoder);
+	QStringList applied;
+	if (p.max_threads >= 0 && g_object_class_find_property(klass, "max-threads") ) {
+		g_object_set(G_OBJECT(decoder), "max-threads", p.max_threads, NULL);
+		applied << QString("max-threads=%1").arg(p.max_threads);
+	}
+	if (p.thread_type >= 0 && g_object_class_find_property(klass, "thread-type") ) {
+		g_object_set(G_OBJECT(decoder), "thread-type", p.thread_type, NULL);
+		applied << QString("thread-type=%1").arg(p.thread_type);
+	}
+	if (p.skip_frame >= 0 && g_object_class_find_property(klass, "skip-frame") )
+		g_object_set(G_OBJECT(decoder), "skip-frame", decoder_loaded ? p.skip_frame : 0, NULL);
+	
+	// queue size, set on the decodebin so it survives decodebin resizing its multiqueue
+	if (p.queue_mb > 0) {
+		GstObject* parent = gst_element_get_parent(decoder);
+		if (parent) {
+			if (g_object_class_find_property(G_OBJECT_GET_CLASS(parent), "max-size-bytes") ) {
+				guint bytes = 0;
+				g_object_get(G_OBJECT(parent), "max-size-bytes", &bytes, NULL);
+				if (static_cast<guint>(p.queue_mb) * 1024 * 1024 > bytes) {
+					g_object_set(G_OBJECT(parent), "max-size-bytes", static_cast<guint>(p.queue_mb) * 1024 * 1024, NULL);
+					applied << QString("queue=%1MB").arg(p.queue_mb);
+				}
+			}	// if max-size-bytes
+			gst_object_unref(parent);
+		}	// if parent
+	}	// if queue_mb
+	
+	if (! applied.isEmpty() )
+		emit signalMessage(MBMP_GI::Application, QString(tr("Tuning decoder %1 (%2 %3p): %4")).arg(name).arg(media).arg(height).arg(applied.join(" ")) );
+	
+	return;
+}
+
+//
+// Function to set skip-frame on a decoder from its profile, or to skip
+// non-reference frames if the profile does not set it.  Skip when the
+// decoders are loaded, otherwise decode everything.  Elements that are not
+// decoders with a skip-frame property are ignored.
+void GST_Interface::applyDecoderLoad(GstElement* element)
+{
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory || ! gst_element_factory_list_is_type(factory, GST_ELEMENT_FACTORY_TYPE_DECODER) ) return;
+	if (! g_object_class_find_property(G_OBJECT_GET_CLASS(element), "skip-frame") ) return;
+	
+	GstPad* pad = gst_element_get_static_pad(element, "sink");
+	if (! pad) return;
+	GstCaps* caps = gst_pad_get_current_caps(pad);
+	gst_object_unref(pad);
+	if (! caps) return;
+	
+	const GstStructure* s = gst_caps_get_structure(caps, 0);
+	gint height = 0;
+	gst_structure_get_int(s, "height", &height);
+	DecoderProfile p;
+	int skip = 1;		// skip B (non-reference) frames unless the profile says otherwise
+	if (findDecoderProfile(QString(GST_OBJECT_NAME(factory)), QString(gst_structure_get_name(s)).section('/', 0, 0), height, p) && p.skip_frame >= 0)
+		skip = p.skip_frame;
+	g_object_set(G_OBJECT(element), "skip-frame", decoder_loaded ? skip : 0, NULL);
+	gst_caps_unref(caps);
+	
+	return;
+}
+
+//
+// Function to apply our variant selection policy to an adaptive stream
+// demuxer.  Elements that are not hlsdemux, dashdemux or mssdemux are
+// ignored.  Setting connection-speed replaces the demuxer's own bandwidth
+// estimate so it always picks the best variant under adaptiveBitrateLimit().
+// Called from streaming threads through elementAdded() so the window size
+// is copied under adaptive_mutex.
+void GST_Interface::applyAdaptiveLimits(GstElement* element)
+{
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory) return;
+	const QString name = QString(GST_OBJECT_NAME(factory));
+	if (name != "hlsdemux" && name != "dashdemux" && name != "mssdemux") return;
+	
+	GObjectClass* klass = G_OBJECT_GET_CLASS(element);
+	if (g_object_class_find_property(klass, "connection-speed") )
+		g_object_set(G_OBJECT(element), "connection-speed", adaptiveBitrateLimit(), NULL);
+	
+	// dashdemux can also limit the resolution directly, 0 means no limit
+	if (g_object_class_find_property(klass, "max-video-width") && g_object_class_find_property(klass, "max-video-height") ) {
+		adaptive_mutex.lock();
+		const QSize area = video_area;
+		const bool b = video_visible && ! area.isEmpty();
+		adaptive_mutex.unlock();
+		g_object_set(G_OBJECT(element), 
+			"max-video-width", static_cast<guint>(b ? area.width() : 0),
+			"max-video-height", static_cast<guint>(b ? area.height() : 0),
+			NULL);
+	}
+	
+	return;
+}
+
+//
+// Function to select a pipeline tuning profile by name.  The playbin buffer
+// settings and play flags are set here, decodebin queues and audio sinks in
+// applyTuning() as they are created.  Most of this only takes effect for the
+// next stream.  The buffering flags the user set are kept when leaving the
+// default profile and put back before any other profile's flags are
+// applied, so going back to default undoes them.  Return false if there is
+// no profile called name.
+bool GST_Interface::setTuningProfile(const QString& name)
+{
+	int idx = -1;
+	for (int i = 0; i < n_tuning_profiles; ++i) {
+		if (name == tuning_profiles[i].name) idx = i;
+	}
+	if (idx < 0) {
+		emit signalMessage(MBMP_GI::Warning, QString(tr("Unknown tuning profile %1")).arg(name) );
+		return false;
+	}
+	
+	if (tuning == 0) {
+		guint flags = 0;
+		g_object_get (pipeline_playbin, "flags", &flags, NULL);
+		tuning_flags = flags & tuning_flag_mask;
+	}
+	else {
+		if (tuning_flags != 0) setPlayFlag(tuning_flags, true);
+		if ((tuning_flag_mask & ~tuning_flags) != 0) setPlayFlag(tuning_flag_mask & ~tuning_flags, false);
+	}
+	
+	tuning_mutex.lock();
+	tuning = idx;
+	tuning_mutex.unlock();
+	const TuningProfile& p = tuning_profiles[tuning];
+	g_object_set (G_OBJECT (pipeline_playbin), "buffer-duration", p.buffer_duration, "buffer-size", p.buffer_size, NULL);
+	if (p.flags_set != 0) setPlayFlag(p.flags_set, true);
+	if (p.flags_clear != 0) setPlayFlag(p.flags_clear, false);
+	
+	// start adaptive buffering over from the new floor
+	buffer_time = -1;
+	buffer_high = 0.0;
+	if (p.adaptive && bw_in > 0.0) tuneBuffering();
+	
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	gst_iterator_foreach (it, tuneElement, this);
+	gst_iterator_free (it);
+	
+	emit signalMessage(MBMP_GI::Application, QString(tr("Tuning profile %1: buffer %2 ms/%3 KB, queues %4 KB/%5 ms, audio sink %6/%7 us, stream buffering %8, download buffering %9"))
+		.arg(p.name)
+		.arg(p.buffer_duration < 0 ? -1 : p.buffer_duration / GST_MSECOND)
+		.arg(p.buffer_size < 0 ? -1 : p.buffer_size / 1024)
+		.arg(p.queue_bytes / 1024)
+		.arg(p.queue_time / GST_MSECOND)
+		.arg(p.sink_buffer)
+		.arg(p.sink_latency)
+		.arg(checkPlayFlag(GST_PLAY_FLAG_BUFFERING) ? tr("on") : tr("off"))
+		.arg(checkPlayFlag(GST_PLAY_FLAG_DOWNLOAD) ? tr("on") : tr("off")) );
+	
+	return true;
+}
+
+//
+// Function to return the names of the tuning profiles
+QStringList GST_Interface::getTuningProfileList()
+{
+	QStringList sl;
+	for (int i = 0; i < n_tuning_profiles; ++i) {
+		sl << tuning_profiles[i].name;
+	}
+	
+	return sl;
+}
+
+//
+// Function to return the name of the tuning profile in use
+QString GST_Interface::getTuningProfile()
+{
+	return QString(tuning_profiles[tuning].name);
+}
+
+//
+// Function to apply the tuning profile to an element.  Sets the decodebin
+// multiqueue limits and the audio sink buffer and latency times, which the
+// sink uses the next time it opens the device.  Other elements are ignored.
+// Called from streaming threads through elementAdded() so the settings
+// are copied under tuning_mutex.
+void GST_Interface::applyTuning(GstElement* element)
+{
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory) return;
+	tuning_mutex.lock();
+	const TuningProfile p = tuning_profiles[tuning];
+	const gint64 out_buffer = audio_buffer;
+	const gint64 out_latency = audio_latency;
+	tuning_mutex.unlock();
+	GObjectClass* klass = G_OBJECT_GET_CLASS(element);
+	
+	if (QString(GST_OBJECT_NAME(factory)) == "decodebin") {
+		if (p.queue_bytes > 0) g_object_set(G_OBJECT(element), "max-size-bytes", p.queue_bytes, NULL);
+		if (p.queue_time > 0) g_object_set(G_OBJECT(element), "max-size-time", p.queue_time, NULL);
+	}
+	
+	// audio sinks, our audio output settings win over the profile.  Keep
+	// at least two segments in the ring buffer.
+	else if (gst_element_factory_list_is_type(factory, GST_ELEMENT_FACTORY_TYPE_SINK | GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO) &&
+		g_object_class_find_property(klass, "buffer-time") && g_object_class_find_property(klass, "latency-time") ) {
+			const gint64 buffer = out_buffer > 0 ? out_buffer : p.sink_buffer;
+			gint64 latency = out_buffer > 0 ? out_latency : p.sink_latency;
+			if (buffer > 0) {
+				if (latency <= 0 || latency > buffer / 2) latency = buffer / 2;
+				g_object_set(G_OBJECT(element), "buffer-time", buffer, "latency-time", latency, NULL);
+			}
+	}	// else if audio sink
+	
+	return;
+}
+
+//
+// Function to read the rendered and dropped counts of a sink into the QoS
+// statistics.  Elements that are not audio or video sinks with a stats
+// property (GStreamer 1.18 and later) are ignored, without it only the
+// QoS messages are counted.
+void GST_Interface::sampleSinkStats(GstElement* element)
+{
+	if (GST_IS_BIN(element) || ! GST_OBJECT_FLAG_IS_SET(element, GST_ELEMENT_FLAG_SINK) ) return;
+	if (! g_object_class_find_property(G_OBJECT_GET_CLASS(element), "stats") ) return;
+	const QString media = qosMedia(element);
+	if (media.isEmpty() ) return;
+	
+	GstStructure* s = NULL;
+	g_object_get(G_OBJECT(element), "stats", &s, NULL);
+	if (! s) return;
+	
+	guint64 rendered = 0;
+	guint64 dropped = 0;
+	if (gst_structure_get_uint64(s, "rendered", &rendered) && gst_structure_get_uint64(s, "dropped", &dropped) ) {
+		QosStats& q = qos_stats[QString(GST_OBJECT_NAME(element))];
+		q.media = media;
+		q.processed = qMax(q.processed, rendered);
+		q.dropped = qMax(q.dropped, dropped);
+	}
+	gst_structure_free(s);
+	
+	return;
+}
+
+//
+// Function to turn the quality degradation ladder on or off.  The
+// downscale step uses the window scaling filter and is skipped without
+// it, the ladder does not put a videoscale in by itself.
+void GST_Interface::setQualityDegradation(bool enable)
+{
+	if (degrade_level > 0) setDegradeLevel(0);
+	degrade_enabled = enable;
+	
+	// without the ladder the QoS alert alone has the decoders skip frames
+	if (decoder_loaded != (! enable && qos_alert) ) setDecoderLoad(! enable && qos_alert);
+	
+	emit signalMessage(MBMP_GI::Application, enable ? tr("Quality degradation under QoS pressure is enabled") : tr("Quality degradation under QoS pressure is disabled") );
+	
+	return;
+}
+
+//
+// Function to turn scaling the video down to the window size on or off.
+// For software video sinks this saves converting and copying full size
+// frames only to have the sink shrink them again.  Takes effect when the
+// next stream starts playing.
+void GST_Interface::setWindowScaling(bool enable)
+{
+	window_scaling = enable;
+	installScaleFilter();
+	
+	emit signalMessage(MBMP_GI::Application, enable ? tr("Video is scaled down to the window size before the sink") : tr("Video is sent to the sink at its own size") );
+	
+	return;
+}
+
+//
+// Function to put the videoscale ! capsfilter bin in as the playbin
+// video-filter if window scaling is on, and to take it out if not.  Only
+// call this with the pipeline stopped.  With the capsfilter open (ANY
+// caps) videoscale passes buffers through, but it only takes system
+// memory so hardware decoders have to copy their surfaces out to get past
+// it.  That is why this is opt-in.
+void GST_Interface::installScaleFilter()
+{
+	const bool wanted = window_scaling;
+	
+	if (wanted && ! scale_caps) {
+		GstElement* bin = gst_parse_bin_from_description("videoscale name=mbmp_scale ! capsfilter name=mbmp_scalecaps", TRUE, NULL);
+		if (bin) {
+			scale_caps = gst_bin_get_by_name(GST_BIN(bin), "mbmp_scalecaps");
+			g_object_set(G_OBJECT(pipeline_playbin), "video-filter", bin, NULL);
+		}
+	}	// if wanted
+	
+	else if (! wanted && scale_caps) {
+		g_object_set(G_OBJECT(pipeline_playbin), "video-filter", NULL, NULL);
+		gst_object_unref(GST_OBJECT(scale_caps));
+		scale_caps = NULL;
+	}	// else if not wanted
+	
+	return;
+}
+
+//
+// Function to set the caps of the video-filter capsfilter from the size
+// of the video coming in.  Halve it on the last degradation step, and if
+// window scaling is on fit it inside the video window.  The window size is
+// rounded up to window_scale_step so resizing the window only renegotiates
+// once in a while.  Video that would not change size is left alone.
+void GST_Interface::updateScaleCaps()
+{
+	if (! scale_caps) return;
+	
+	// the size coming into videoscale
+	GstCaps* current = NULL;
+	GstObject* parent = gst_object_get_parent(GST_OBJECT(scale_caps));
+	if (parent) {
+		GstElement* scale = gst_bin_get_by_name(GST_BIN(parent), "mbmp_scale");
+		if (scale) {
+			GstPad* pad = gst_element_get_static_pad(scale, "sink");
+			current = gst_pad_get_current_caps(pad);
+			gst_object_unref(pad);
+			gst_object_unref(scale);
+		}
+		gst_object_unref(parent);
+	}	// if parent
+	
+	GstCaps* caps = NULL;
+	if (current && gst_caps_features_contains(gst_caps_get_features(current, 0), GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY) ) {
+		gint width = 0;
+		gint height = 0;
+		const GstStructure* s = gst_caps_get_structure(current, 0);
+		if (gst_structure_get_int(s, "width", &width) && gst_structure_get_int(s, "height", &height) && width > 0 && height > 0) {
+			double factor = (degrade_taken & (1 << 3)) ? 0.5 : 1.0;
+			if (window_scaling && video_visible && ! video_area.isEmpty() ) {
+				const int box_w = ((video_area.width() + window_scale_step - 1) / window_scale_step) * window_scale_step;
+				const int box_h = ((video_area.height() + window_scale_step - 1) / window_scale_step) * window_scale_step;
+				factor = qMin(factor, qMin(static_cast<double>(box_w) / width, static_cast<double>(box_h) / height) );
+			}
+			if (factor < 1.0) {
+				caps = gst_caps_copy(current);
+				gst_caps_set_simple(caps, 
+					"width", G_TYPE_INT, qMax(static_cast<int>(width * factor) & ~1, 2), 
+					"height", G_TYPE_INT, qMax(static_cast<int>(height * factor) & ~1, 2), 
+					NULL);
+			}
+		}	// if width and height
+	}	// if system memory
+	if (current) gst_caps_unref(current);
+	if (! caps) caps = gst_caps_new_any();
+	
+	// only renegotiate if the caps really change
+	GstCaps* old = NULL;
+	g_object_get(G_OBJECT(scale_caps), "caps", &old, NULL);
+	if (! old || ! gst_caps_is_equal(old, caps) )
+		g_object_set(G_OBJECT(scale_caps), "caps", caps, NULL);
+	if (old) gst_caps_unref(old);
+	gst_caps_unref(caps);
+	
+	return;
+}
+
+//
+// Function to cap the visualizer framerate (fps, 0 for no cap) and set its
+// size (an invalid size follows the video window).  If no visualizer has
+// been picked yet put the playbin default (goom) in so it gets the caps.
+void GST_Interface::setVisualizerCaps(int fps, const QSize& size)
+{
+	vis_fps = qMax(fps, 0);
+	vis_size = size.isValid() && ! size.isEmpty() ? size : QSize();
+	
+	if (vis_caps)
+		updateVisCaps();
+	else {
+		GstElementFactory* factory = vis_factory ? GST_ELEMENT_FACTORY(gst_object_ref(vis_factory)) : gst_element_factory_find("goom");
+		if (factory) {
+			g_object_set (pipeline_playbin, "vis-plugin", makeVisualizer(factory), NULL);
+			gst_object_unref(factory);
+		}
+	}	// else
+	
+	emit signalMessage(MBMP_GI::Application, QString(tr("Visualizer capped at %1, size %2"))
+		.arg(vis_fps > 0 ? QString(tr("%1 fps")).arg(vis_fps) : tr("any framerate"))
+		.arg(vis_size.isValid() ? QString("%1x%2").arg(vis_size.width()).arg(vis_size.height()) : tr("of the video window")) );
+	
+	return;
+}
+
+//
+// Function to turn the tracer profiling mode on or off.  While on the
+// latency, rusage, stats and queue-levels tracers feed the profile box in
+// StreamInfo.
+void GST_Interface::setProfiling(bool enable)
+{
+	enable ? profiler->start() : profiler->stop();
+	streaminfo->setProfileBoxVisible(enable);
+	emit signalMessage(MBMP_GI::Application, enable ? tr("Pipeline profiling is on") : tr("Pipeline profiling is off") );
+	
+	return;
+}
+
+//
+// Function to set up the audio output stage.  sink is the audio sink
+// element to use, empty for the playbin default.  buffer_ms and latency_ms
+// are the sink buffer-time and latency-time, 0 leaves them to the tuning
+// profile.  With a buffer set volume is left to the sink when it has a
+// volume property of its own, so a volume change is heard right away and
+// not a buffer later.  The sink is used from the next stream on, until
+// then playbin keeps doing the volume.
+void GST_Interface::setAudioOutput(const QString& sink, int buffer_ms, int latency_ms)
+{
+	audio_sink = sink.simplified();
+	audio_sink_set = false;
+	tuning_mutex.lock();
+	audio_buffer = static_cast<gint64>(qMax(buffer_ms, 0)) * 1000;
+	audio_latency = static_cast<gint64>(qMax(latency_ms, 0)) * 1000;
+	tuning_mutex.unlock();
+	setPlayFlag(GST_PLAY_FLAG_SOFT_VOLUME, true);
+	
+	if (! audio_sink.isEmpty() || audio_buffer > 0)
+		emit signalMessage(MBMP_GI::Application, QString(tr("Audio output: sink %1, buffer %2 ms, latency %3 ms"))
+			.arg(audio_sink.isEmpty() ? tr("default") : audio_sink)
+			.arg(buffer_ms)
+			.arg(latency_ms) );
+	
+	return;
+}
+
+//
+// Function to set the scheduling of the audio streaming threads.  policy is
+// "fifo" or "rr" for real-time scheduling, "nice" to only raise the nice
+// value, anything else leaves the threads alone.  cpus is a comma separated
+// list of CPU numbers to pin the threads to, empty for no pinning.  Both
+// are applied as the threads are created so set them before playing.
+void GST_Interface::setAudioThreadPolicy(const QString& policy, const QString& cpus)
+{
+	const QString p = policy.simplified().toLower();
+	if (p == "fifo") thread_policy = SCHED_FIFO;
+	else if (p == "rr") thread_policy = SCHED_RR;
+		else if (p == "nice") thread_policy = SCHED_OTHER;
+			else thread_policy = -1;
+	
+	thread_cpus.clear();
+	const QStringList sl = cpus.split(',', QString::SkipEmptyParts);
+	for (int i = 0; i < sl.count(); ++i) {
+		bool ok = false;
+		const int cpu = sl.at(i).trimmed().toInt(&ok);
+		if (ok && cpu >= 0 && cpu < CPU_SETSIZE && ! thread_cpus.contains(cpu) ) thread_cpus.append(cpu);
+	}
+	
+	if (thread_policy >= 0 || ! thread_cpus.isEmpty() )
+		emit signalMessage(MBMP_GI::Application, QString(tr("Audio thread policy: %1, CPUs %2"))
+			.arg(thread_policy >= 0 ? p : tr("default"))
+			.arg(thread_cpus.isEmpty() ? tr("any") : cpus.simplified()) );
+	
+	return;
+}
+
+//
+// Function to set the timeshift ring buffer for network streams.  size is
+// a number of minutes followed by "min", or a number of megabytes with an
+// optional "MB".  0 or empty turns timeshift off.  A size in minutes also
+// limits how far back we shift, the ring itself is sized for an 8 Mbit/s
+// stream.  Used from the next stream on.
+void GST_Interface::setTimeshift(const QString& size)
+{
+	QString s = size.simplified().toLower();
+	ts_bytes = 0;
+	ts_secs = 0;
+	
+	if (s.endsWith("min") ) {
+		s.chop(3);
+		const int minutes = qMax(s.trimmed().toInt(), 0);
+		ts_bytes = static_cast<guint64>(minutes) * timeshift_bytes_per_min;
+		ts_secs = minutes * 60;
+	}
+	else {
+		if (s.endsWith("mb") ) s.chop(2);
+		ts_bytes = static_cast<guint64>(qMax(s.trimmed().toInt(), 0)) * 1024 * 1024;
+	}
+	
+	if (ts_bytes > 0)
+		emit signalMessage(MBMP_GI::Application, QString(tr("Timeshift enabled for network streams: %1 MB%2"))
+			.arg(ts_bytes / (1024 * 1024))
+			.arg(ts_secs > 0 ? QString(tr(", up to %1 minutes back")).arg(ts_secs / 60) : QString()) );
+	
+	return;
+}
+
+//
+// Function to set the size in megabytes of the persistent cache for remote
+// media files, 0 turns it off.  Used from the next stream on.
+void GST_Interface::setMediaCache(int mb)
+{
+	mediacache->setBudget(mb);
+	
+	if (mediacache->isEnabled() )
+		emit signalMessage(MBMP_GI::Application, QString(tr("Media cache for remote files: %1 MB")).arg(mb) );
+	
+	return;
+}
+
+//
+// Function to get ready to play uri next.  The connection to the server is
+// opened, so the first buffer after the track change does not wait on DNS,
+// TCP and TLS, and uri is then played through the media cache server to
+// use it.  With the cache on the start of the file is fetched as well.
+void GST_Interface::warmUri(const QString& uri)
+{
+	mediacache->warm(uri);
+	
+	return;
+}
+
+//
+// Function to configure the download cache used when GST_PLAY_FLAG_DOWNLOAD
+// is set.  mb is the ring buffer size in megabytes, 0 keeps the entire file.
+// If in_memory is true the ring buffer is kept in RAM, otherwise in a temp
+// file.  Seeks inside the cached range are served from the cache.
+void GST_Interface::setDownloadCache(const guint64& mb, const bool& in_memory)
+{
+	ringbuffer_size = mb * 1024 * 1024;
+	ringbuffer_memory = in_memory;
+	g_object_set (G_OBJECT (pipeline_playbin), "ring-buffer-max-size", ringbuffer_size, NULL);
+	
+	if (ringbuffer_size > 0)
+		emit signalMessage(MBMP_GI::Application, QString(tr("Download cache is a %1 MB ring buffer in %2")).arg(mb).arg(in_memory ? tr("memory") : tr("a temporary file")) );
+	
+	return;
+}
+
+//////////////////////////// Public Slots ////////////////////////////
+//
+// Slot to process a mouse navigation event.  Our VideoWidget emits a signal
+// (via PlayerCtl) containing the mouse event data. The signal is connected
+// to this function which then injects the mouse event into the stream
+void GST_Interface::mouseNavEvent(QString event, int button, int x, int y)
+{
+  // Do nothing if we are not playing 
+  if (getState() != GST_STATE_PLAYING)  return;
+    
+  // Find the gstNavigation element (part of xvimagesink)
+  GstNavigation* nav = 0;           
+  nav = GST_NAVIGATION (pipeline_playbin);
+  
+  // Return if we could not find a GstNavigation element in the pipeline
+  if (! nav) return;
+  
+  // Inject the mouse event data into the stream
+  gst_navigation_send_mouse_event(nav, qPrintable(event), button, static_cast<double>(x), static_cast<double>(y));
+  
+  return;
+}
+
+//
+//  Slot to process a key navigation event
+void GST_Interface::keyNavEvent(GstNavigationCommand cmd)
+{
+  // Do nothing if we are not playing 
+  if (getState() != GST_STATE_PLAYING)  return;
+  
+  // Find the gstNavigation element (part of xvimagesink)
+  GstNavigation* nav = 0;           
+  nav = GST_NAVIGATION (pipeline_playbin);  
+  
+  // Return if we could not find a GstNavigation element in the pipeline
+  if (! nav) return;  
+  
+  // Inject the command into the stream
+  gst_navigation_send_command(nav, cmd);
+  
+  return;
+}
+
+//
+// Slot to seek to a specific position in the stream. Seek position
+// sent is in seconds so need to convert it to nanoseconds for gstreamer
+// Called when a QAction is triggered
+void GST_Interface::seekToPosition(int position)
+{
+  // return if seeking is not enabled
+  if (! this->queryStreamSeek() ) return;
+  
+  // keep a timeshift seek inside the part of the ring buffer we still have
+  gint64 target = static_cast<gint64>(position) * GST_SECOND;
+  if (isTimeshifting() && ts_clock.isValid() ) 
+		target = qBound(timeshiftStart(), target, timeshiftLiveEdge() - GST_SECOND);
+  
+  // seek flags
+  int seekflags =  GST_SEEK_FLAG_FLUSH    | // flush the pipeline_playbin
+                    GST_SEEK_FLAG_SKIP     | // allow skipping frames
+                    GST_SEEK_FLAG_KEY_UNIT ; // seek to the nearest keyframe, faster but maybe not as accurate
+  
+  // a seek ends trick mode, stay on keyframes only if the video is hidden
+  if (hidden_decoding) seekflags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS;
+                         	 
+  // now do the seek
+  gst_element_seek_simple(pipeline_playbin, GST_FORMAT_TIME, (GstSeekFlags)(seekflags) , target);
+  return;
+} 
+
+//
+// Slot to jump from wherever we are in the timeshift ring buffer to the
+// live edge.  If paused playback is restarted.
+void GST_Interface::jumpToLive()
+{
+	if (! isTimeshifting() || ! ts_clock.isValid() ) return;
+	
+	if (getState() == GST_STATE_PAUSED) {
+		gst_element_set_state(pipeline_playbin, GST_STATE_PLAYING);
+		gst_element_get_state(pipeline_playbin, NULL, NULL, GST_SECOND);
+	}
+	seekToPosition(static_cast<int>(timeshiftLiveEdge() / GST_SECOND) );
+	emit signalMessage(MBMP_GI::Application, tr("Timeshift: back to live") );
+	
+	return;
+}
+
+//
+// Slot to start or stop recording the stream we are playing.  The file is
+// named after the file or stream and goes in the record directory.  The
+// recordingChanged signal tells whether we really are recording.
+void GST_Interface::toggleRecording(bool b_record)
+{
+	if (! b_record) {
+		stopRecording();
+		if (! video_visible) hide_timer->start();
+		return;
+	}
+	if (recorder->isRecording() ) return;
+	
+	// a hidden video only gets keyframes or is dropped, record every frame
+	setHiddenDecoding(false);
+	setHiddenVideo(false);
+	
+	gchar* uri = NULL;
+	g_object_get(G_OBJECT(pipeline_playbin), "current-uri", &uri, NULL);
+	QString name = uri ? QFileInfo(QUrl(QString::fromUtf8(uri)).path()).completeBaseName() : QString();
+	g_free(uri);
+	if (name.isEmpty() ) name = QString("%1-recording").arg(QString(APP).toLower());
+	
+	if (getState() != GST_STATE_PLAYING && getState() != GST_STATE_PAUSED)
+		emit signalMessage(MBMP_GI::Warning, tr("Recording not started: nothing is playing") );
+	else if (recorder->start(pipeline_playbin, record_dir, name) )
+		emit signalMessage(MBMP_GI::Application, tr("Recording to %1").arg(recorder->fileName()) );
+	else
+		emit signalMessage(MBMP_GI::Warning, tr("Recording not started: %1").arg(recorder->errorString()) );
+	
+	if (! recorder->isRecording() && ! video_visible) hide_timer->start();
+	emit recordingChanged(recorder->isRecording() );
+	return;
+}
+
+
+//
+// Slot to change the audio stream to the stream number sent
+void GST_Interface::setAudioStream(const int& stream)
+{
+  // make sure the stream exists
+  if (stream < 0 || stream >= (streammap["n-audio"]) ) return;
+      
+  // change the stream to the int sent to the function
+  g_object_set (G_OBJECT (pipeline_playbin), "current-audio", stream, NULL);
+    
+  // update the streammap and then the text display boxes
+  streammap["current-audio"] = stream;
+  streaminfo->updateAudioBox(getAudioStreamInfo());
+    
+  return;
+} 
+
+//
+// Slot to change the video stream to the stream number sent
+void GST_Interface::setVideoStream(const int& stream)
+{
+  // make sure the stream exists
+  if (stream < 0 || stream >= (streammap["n-video"]) ) return;
+      
+  // change the stream to the int sent to the function
+  g_object_set (G_OBJECT (pipeline_playbin), "current-video", stream, NULL);
+    
+  // update the streammap and text display boxes
+  streammap["current-video"] = stream;
+  streaminfo->updateVideoBox(getVideoStreamInfo());
+  
+  return;
+} 
+
+//
+// Slot to change the subtitle stream to the stream number sent
+void GST_Interface::setTextStream(const int& stream)
+{
+  // make sure the stream exists
+  if (stream < 0 || stream >= (streammap["n-text"]) ) return;
+  
   // change the stream to the int sent to the function
   g_object_set (G_OBJECT (pipeline_playbin), "current-text", stream, NULL);
   
@@ -1262,6 +2733,7 @@ void GST_Interface::changeConnectionSpeed(const guint64& ui64_speed)
 { 
   // change the connection soeed to the ui64 sent to the function
   g_object_set (G_OBJECT (pipeline_playbin), "connection-speed", ui64_speed, NULL);
+  bw_applied = ui64_speed;
   emit signalMessage(MBMP_GI::Application, QString(tr("Changing connection speed to %1")).arg(ui64_speed) );
     
   return;
@@ -1274,10 +2746,168 @@ void GST_Interface::changeConnectionSpeed(const guint64& ui64_speed)
 // signal to Playerctl that we had a state change.
 void GST_Interface::playerStop()
 {
+	stopRecording();
 	gst_element_set_state (pipeline_playbin, GST_STATE_NULL);
 	emit signalMessage(MBMP_GI::State, QString("%1 has changed state to %2").arg(PLAYER_NAME).arg(gst_element_state_get_name(GST_STATE_NULL)) );
 	opticaldrive.clear();
+	qos_timer->stop();
+	restoreFastPath();
+	clearTimeshift();
+	
+	return;
+}
+
+//
+// Slot to write a DOT graph of the running pipeline, annotated with the
+// profile numbers if we have them.  Called from the StreamInfo dialog.
+void GST_Interface::dumpPipelineGraph()
+{
+	const QString fn = profiler->dumpGraph(pipeline_playbin);
+	if (fn.isEmpty() )
+		emit signalMessage(MBMP_GI::Warning, tr("Could not write the pipeline graph") );
+	else
+		emit signalMessage(MBMP_GI::Info, QString(tr("Pipeline graph written to %1")).arg(fn) );
+	
+	return;
+}
+
+//
+// Slot to tell us the size of the video window and if it can be seen.
+// Called from PlayerControl when the video window is resized, shown or
+// hidden.  Adaptive streams playing now are updated, they switch variants
+// at their next fragment.  Keyframe only decoding and dropping the video of
+// a URL stream wait for hide_timer so a quick page switch costs nothing.
+void GST_Interface::setVideoArea(const QSize& area, bool visible)
+{
+	if (area == video_area && visible == video_visible) return;
+	
+	if (visible != video_visible && checkCurrent(MBMP_GI::Url) )
+		emit signalMessage(MBMP_GI::Application, visible ? tr("Video window visible, adaptive streams may use video variants") : tr("Video window hidden, adaptive streams limited to the lowest variant and their video dropped") );
+	const bool changed = visible != video_visible;
+	adaptive_mutex.lock();
+	video_area = area;
+	video_visible = visible;
+	adaptive_mutex.unlock();
+	
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	gst_iterator_foreach (it, adaptiveLimits, this);
+	gst_iterator_free (it);
+	
+	if (changed) {
+		if (visible) {
+			setHiddenDecoding(false);
+			setHiddenVideo(false);
+		}
+		else hide_timer->start();
+	}
+	if (window_scaling && visible) updateScaleCaps();
+	if (visible) updateVisCaps();
+	
+	return;
+}
+
+//
+// Slot to show or hide the color balance dialog
+void GST_Interface::toggleColorBalance()
+{
+	colorbalance->isVisible() ? colorbalance->hide() : colorbalance->show();
+	
+	return;
+}
+
+//
+// Slot to set one color balance channel (brightness, contrast, hue or
+// saturation) to a value from -100 to 100, 0 is no adjustment.  Called
+// from the ColorBalance dialog.
+void GST_Interface::setColorBalance(const QString& channel, int value)
+{
+	if (! balance.contains(channel) ) return;
+	balance[channel] = qBound(-100, value, 100);
+	balance_touched = true;
+	applyColorBalance();
+	
+	return;
+}
+
+//
+// Slot to set the area of the video window the sink draws in, in device
+// pixels.  Called from the VideoWidget (throttled) when it is resized.  The
+// sink scales into the rectangle itself so a resize or going fullscreen
+// needs no caps renegotiation.  playbin keeps the rectangle for sinks it
+// creates later.
+void GST_Interface::setRenderRectangle(const QRect& rect)
+{
+	if (! rect.isValid() || rect == render_rect) return;
+	render_rect = rect;
+	
+	gst_video_overlay_set_render_rectangle(GST_VIDEO_OVERLAY(pipeline_playbin), rect.x(), rect.y(), rect.width(), rect.height() );
+	gst_video_overlay_expose(GST_VIDEO_OVERLAY(pipeline_playbin) );
+	
+	return;
+}
+
+//
+// Slot to have the video sink redraw its last frame.  Called from the 
+// VideoWidget instead of painting the window itself.
+void GST_Interface::exposeVideo()
+{
+	gst_video_overlay_expose(GST_VIDEO_OVERLAY(pipeline_playbin) );
+	
+	return;
+}
+
+//
+// Slot to receive the decoder and video sink ranking from DecoderBenchmark.
+// Keys are codec caps names with a QStringList of decoders, fastest first,
+// and "video-sink:" plus a codec caps name with a QStringList of sinks.
+// Decoders are applied per codec through decodebin's autoplug-sort so a
+// decoder handling several codecs is only preferred where it won.  Sinks
+// are per codec too, chooseVideoSink() picks one once the codec is known.
+// The sink bin is given to playbin at the next playMedia().
+void GST_Interface::setDecoderRanking(const QVariantMap& ranking)
+{
+	QMutexLocker locker(&ranking_mutex);
+	dec_ranking.clear();
+	codec_sinks.clear();
+	
+	QVariantMap::const_iterator it;
+	for (it = ranking.constBegin(); it != ranking.constEnd(); ++it) {
+		if (it.key().startsWith("video-sink:") ) {
+			const QStringList sinks = it.value().toStringList();
+			if (! sinks.isEmpty() ) codec_sinks.insert(it.key().section(':', 1), sinks.first() );
+		}
+		else {
+			dec_ranking.insert(it.key(), it.value().toStringList() );
+			emit signalMessage(MBMP_GI::Application, QString(tr("Decoder ranking for %1: %2")).arg(it.key()).arg(it.value().toStringList().join(", ")) );
+		}
+	}	// for
+	
+	return;
+}
+
+//
+// Slot to set the decoder tuning profiles.  Each QVariantMap is one profile
+// as read by Settings::getDecoderProfiles().  Applied to decoders as they
+// are created.
+void GST_Interface::setDecoderProfiles(const QList<QVariantMap>& profiles)
+{
+	QMutexLocker locker(&profile_mutex);
+	dec_profiles.clear();
 	
+	for (int i = 0; i < profiles.count(); ++i) {
+		DecoderProfile p;
+		p.factories = profiles.at(i).value("factories").toString().split(',', QString::SkipEmptyParts);
+		p.media = profiles.at(i).value("media").toString();
+		p.min_height = profiles.at(i).value("min_height", 0).toInt();
+		p.max_threads = profiles.at(i).value("max_threads", -1).toInt();
+		p.thread_type = profiles.at(i).value("thread_type", -1).toInt();
+		p.skip_frame = profiles.at(i).value("skip_frame", -1).toInt();
+		p.queue_mb = profiles.at(i).value("queue_mb", -1).toInt();
+		if (p.factories.isEmpty() ) continue;
+		dec_profiles << p;
+	}	// for
+	
+	emit signalMessage(MBMP_GI::Application, QString(tr("Loaded %1 decoder tuning profiles")).arg(dec_profiles.count()) );
 	return;
 }
 
@@ -1356,42 +2986,716 @@ bool GST_Interface::checkCurrent(int testval)
 {
 	return ( (testval & mediatype) == 0 ? false : true);	
 }
+
+//
+// Function to update our throughput estimate from the statistics in a
+// buffering message.  Rates are smoothed with an exponential moving average
+// so a single slow or fast sample does not count for much.  The input rate
+// is fed to the playbin connection-speed, which is used when selecting
+// streams, but only when it moves by more than 25% from the last value.
+void GST_Interface::updateThroughput(GstMessage* msg)
+{
+	GstBufferingMode mode;
+	gint avg_in = -1;
+	gint avg_out = -1;
+	gst_message_parse_buffering_stats (msg, &mode, &avg_in, &avg_out, NULL);
+	
+	if (avg_in > 0) bw_in = (bw_in <= 0.0) ? avg_in : 0.8 * bw_in + 0.2 * avg_in;
+	if (avg_out > 0) bw_out = (bw_out <= 0.0) ? avg_out : 0.8 * bw_out + 0.2 * avg_out;
+	if (bw_in <= 0.0) return;
+	
+	const guint64 kbps = static_cast<guint64>(bw_in * 8.0 / 1000.0);
+	if (bw_applied == 0 || kbps > bw_applied * 5 / 4 || kbps < bw_applied * 3 / 4) {
+		g_object_set (G_OBJECT (pipeline_playbin), "connection-speed", kbps, NULL);
+		bw_applied = kbps;
+		emit signalMessage(MBMP_GI::Application, QString(tr("Measured throughput %1 kbps, connection speed updated")).arg(kbps) );
+	}
+	
+	return;
+}
+
+//
+// Function to size the stream buffer for the measured connection.  The
+// ratio of input rate to playback rate picks a base buffer duration and
+// high watermark, each recent early stall (stall_level) doubles the duration.
+// Applied to the playbin buffer-duration for new streams and directly to
+// the buffering queues of the current stream.
+void GST_Interface::tuneBuffering()
+{
+	// profiles with fixed buffers opt out
+	if (! tuning_profiles[tuning].adaptive) return;
+	
+	// a long stretch of smooth playback relaxes one stall level
+	if (resume_timer.isValid() && resume_timer.elapsed() > relax_window && stall_level > 0) --stall_level;
+	
+	const double ratio = (bw_in > 0.0 && bw_out > 0.0) ? bw_in / bw_out : 1.0;
+	BufferLimits lim;
+	lim.low = 0.02;
+	if (ratio >= 1.5) {
+		lim.time = min_buffer_time;
+		lim.high = 0.30;
+	}
+	else if (ratio >= 1.0) {
+		lim.time = 5 * GST_SECOND;
+		lim.high = 0.60;
+	}
+	else {
+		lim.time = 10 * GST_SECOND;
+		lim.high = 0.99;
+	}
+	lim.time = qMin(qMax(lim.time << stall_level, tuning_profiles[tuning].buffer_duration), max_buffer_time);
+	if (stall_level > 0) lim.high = 0.99;
+	
+	if (lim.time == buffer_time && lim.high == buffer_high) return;
+	buffer_time = lim.time;
+	buffer_high = lim.high;
+	
+	g_object_set (G_OBJECT (pipeline_playbin), "buffer-duration", buffer_time, NULL);
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	gst_iterator_foreach (it, setBufferLimits, &lim);
+	gst_iterator_free (it);
+	
+	emit signalMessage(MBMP_GI::Application, QString(tr("Stream buffer set to %1 seconds, high watermark %2%")).arg(buffer_time / GST_SECOND).arg(static_cast<int>(buffer_high * 100)) );
+	
+	return;
+}
+
+//
+// Function to find the decoder profile for a decoder factory name, media
+// type (video or audio) and stream height.  The matching profile with the
+// largest min_height wins, on a tie the first one.  Return false if none
+// match.  Called from streaming threads.
+bool GST_Interface::findDecoderProfile(const QString& factory, const QString& media, int height, DecoderProfile& profile)
+{
+	QMutexLocker locker(&profile_mutex);
+	int best = -1;
+	
+	for (int i = 0; i < dec_profiles.count(); ++i) {
+		const DecoderProfile& p = dec_profiles.at(i);
+		if (! p.media.isEmpty() && p.media != media) continue;
+		if (p.min_height > height) continue;
+		if (best >= 0 && p.min_height <= dec_profiles.at(best).min_height) continue;
+		for (int j = 0; j < p.factories.count(); ++j) {
+			if (QRegExp(p.factories.at(j).trimmed(), Qt::CaseSensitive, QRegExp::Wildcard).exactMatch(factory) ) {
+				best = i;
+				break;
+			}
+		}	// for j
+	}	// for i
+	
+	if (best < 0) return false;
+	profile = dec_profiles.at(best);
+	return true;
+}
+
+//
+// Function to switch the decoders in and out of frame skipping
+void GST_Interface::setDecoderLoad(bool loaded)
+{
+	decoder_loaded = loaded;
+	emit signalMessage(MBMP_GI::Application, loaded ? tr("Decoders can't keep up, skipping frames") : tr("Decoders have caught up, decoding all frames") );
+	
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	gst_iterator_foreach (it, decoderLoad, this);
+	gst_iterator_free (it);
+	
+	return;
+}
+
+//
+// Function to return the bitrate limit (kbps) for adaptive stream variants.
+// 80% of the measured bandwidth, capped at roughly what the video window
+// can show (0.1 bits per pixel at 30 fps).  If the video can't be seen
+// return 1, the demuxer then falls back to its lowest variant.  That is
+// only audio if the audio is a variant of its own, most HLS streams have
+// it as an alternate rendition instead, setHiddenVideo() drops the video
+// for those.  0 means no limit.  Also called
+// from streaming threads, what it reads is copied under adaptive_mutex.
+guint GST_Interface::adaptiveBitrateLimit()
+{
+	adaptive_mutex.lock();
+	const QSize area = video_area;
+	const bool visible = video_visible;
+	const guint bw = adaptive_bw;
+	adaptive_mutex.unlock();
+	if (! visible) return 1;
+	
+	guint kbps = bw * 4 / 5;
+	if (! area.isEmpty() ) {
+		const guint cap = static_cast<guint>(area.width()) * static_cast<guint>(area.height()) * 3 / 1000;
+		if (kbps == 0 || cap < kbps) kbps = cap;
+	}
+	
+	return kbps;
+}
+
+//
+// Function to process the statistics an adaptive demuxer posts for each
+// fragment.  Size over download time is the bandwidth, size over the
+// fragment duration is the bitrate of the variant we are playing.  The
+// demuxers are told about a new bandwidth when it moves by more than 25%.
+void GST_Interface::updateAdaptiveStats(const GstStructure* s)
+{
+	guint64 size = 0;
+	guint64 dltime = 0;
+	guint64 start = GST_CLOCK_TIME_NONE;
+	guint64 stop = GST_CLOCK_TIME_NONE;
+	gst_structure_get_uint64 (s, "fragment-size", &size);
+	gst_structure_get_uint64 (s, "fragment-download-time", &dltime);
+	gst_structure_get_uint64 (s, "fragment-start-time", &start);
+	gst_structure_get_uint64 (s, "fragment-stop-time", &stop);
+	if (size == 0 || dltime == 0 || ! GST_CLOCK_TIME_IS_VALID(dltime) ) return;
+	
+	// measured bandwidth, smoothed
+	const guint kbps = static_cast<guint>(size * 8 * GST_SECOND / dltime / 1000);
+	const guint old_bw = adaptive_bw;
+	adaptive_mutex.lock();
+	adaptive_bw = (adaptive_bw == 0) ? kbps : (adaptive_bw * 4 + kbps) / 5;
+	adaptive_mutex.unlock();
+	if (old_bw == 0 || adaptive_bw > old_bw * 5 / 4 || adaptive_bw < old_bw * 3 / 4) {
+		GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+		gst_iterator_foreach (it, adaptiveLimits, this);
+		gst_iterator_free (it);
+	}
+	
+	// variant bitrate
+	if (GST_CLOCK_TIME_IS_VALID(start) && GST_CLOCK_TIME_IS_VALID(stop) && stop > start) {
+		const guint vkbps = static_cast<guint>(size * 8 * GST_SECOND / (stop - start) / 1000);
+		if (variant_kbps == 0 || vkbps > variant_kbps * 5 / 4 || vkbps < variant_kbps * 3 / 4) {
+			variant_kbps = vkbps;
+			emit signalMessage(MBMP_GI::Application, QString(tr("Adaptive stream variant is now about %1 kbps")).arg(variant_kbps) );
+		}
+	}
+	
+	const guint limit = adaptiveBitrateLimit();
+	QString ss = tr("Adaptive stream");
+	ss.append(tr("\nVariant bitrate: about %1 kbps").arg(variant_kbps) );
+	if (! video_area.isEmpty() && video_visible ) ss.append(tr("\nResolution limit: %1x%2").arg(video_area.width()).arg(video_area.height()) );
+	ss.append(tr("\nMeasured bandwidth: %1 kbps").arg(adaptive_bw) );
+	ss.append(limit == 0 ? tr("\nBitrate limit: none") : tr("\nBitrate limit: %1 kbps").arg(limit) );
+	if (! video_visible) ss.append(hidden_flags ? tr("\nVideo hidden, video dropped and lowest variant selected") : tr("\nVideo hidden, lowest variant selected") );
+	streaminfo->updateNetworkBox(ss);
+	
+	return;
+}
+
+//
+// Function to return true if degradation step does anything for the stream
+// playing.  The visualizer step needs an audio only stream with the
+// visualizer on, deinterlacing needs the deinterlace flag and downscaling
+// needs the window scaling filter with video in system memory.
+bool GST_Interface::degradeStepUsable(int step)
+{
+	switch (step) {
+		case 1:
+			return checkPlayFlag(GST_PLAY_FLAG_VIS) && streammap.value("n-video") < 1;
+		case 2:
+			return checkPlayFlag(GST_PLAY_FLAG_DEINTERLACE) && streammap.value("n-video") > 0;
+		case 4:
+			return true;
+		case 3: {
+			if (! scale_caps) return false;
+			bool b = false;
+			GstPad* pad = gst_element_get_static_pad(scale_caps, "sink");
+			GstCaps* caps = pad ? gst_pad_get_current_caps(pad) : NULL;
+			if (caps) {
+				b = gst_caps_features_contains(gst_caps_get_features(caps, 0), GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY);
+				gst_caps_unref(caps);
+			}
+			if (pad) gst_object_unref(pad);
+			return b; }
+		default:
+			return false;
+	}	// switch
+}
+
+//
+// Function to move to a degradation level.  Steps between the old and new
+// level are applied going up and undone going down, each one is logged.
+// Steps that did nothing for the stream are skipped going up, and only the
+// steps that were applied are undone going down.
+void GST_Interface::setDegradeLevel(int level)
+{
+	const int old = degrade_level;
+	const bool on = level > old;
+	degrade_level = level;
+	degrade_wait = 0;
+	degrade_calm = 0;
+	
+	for (int step = qMin(old, level) + 1; step <= qMax(old, level); ++step) {
+		if (on && ! degradeStepUsable(step) ) continue;
+		if (! on && ! (degrade_taken & (1 << step)) ) continue;
+		if (on) degrade_taken |= (1 << step);
+			else degrade_taken &= ~(1 << step);
+		
+		switch (step) {
+			// visualizer framerate, the playbin default visualizer is goom.
+			// degrade_taken is already set so visFramerate() sees it.
+			case 1: {
+				if (vis_caps) {
+					updateVisCaps();
+					break;
+				}
+				GstElementFactory* factory = vis_factory ? GST_ELEMENT_FACTORY(gst_object_ref(vis_factory)) : gst_element_factory_find("goom");
+				if (factory) {
+					g_object_set (pipeline_playbin, "vis-plugin", makeVisualizer(factory), NULL);
+					gst_object_unref(factory);
+				}
+				break; }
+			
+			// deinterlacer method
+			case 2: {
+				GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+				gst_iterator_foreach (it, degradeDeinterlace, (gpointer) &on);
+				gst_iterator_free (it);
+				break; }
+			
+			// half size video into the sink, keeping the format and aspect.
+			// degrade_taken is already set so updateScaleCaps() sees it.
+			case 3: 
+				updateScaleCaps();
+				break;
+			
+			// decoder skip-frame
+			case 4:
+				setDecoderLoad(on);
+				break;
+			
+			default:
+				break;
+		}	// switch
+		
+		emit signalMessage(MBMP_GI::Application, QString(tr("Quality step %1 %2: %3")).arg(step).arg(on ? tr("taken") : tr("undone")).arg(tr(degrade_steps[step])) );
+	}	// for
+	
+	return;
+}
+
+//
+// Function to create a visualizer from factory.  The visualizer is wrapped
+// in a bin with a capsfilter (vis_caps) that caps its framerate and size,
+// and a probe on the capsfilter counts the frames for the QoS statistics.
+// Return NULL if the visualizer can't be created.
+GstElement* GST_Interface::makeVisualizer(GstElementFactory* factory)
+{
+	GstElement* vis = gst_element_factory_create(factory, NULL);
+	if (! vis) return vis;
+	
+	GstElement* filter = gst_element_factory_make("capsfilter", NULL);
+	if (! filter) return vis;
+	
+	GstElement* bin = gst_bin_new(NULL);
+	gst_bin_add_many(GST_BIN(bin), vis, filter, NULL);
+	gst_element_link(vis, filter);
+	GstPad* pad = gst_element_get_static_pad(vis, "sink");
+	gst_element_add_pad(bin, gst_ghost_pad_new("sink", pad) );
+	gst_object_unref(pad);
+	pad = gst_element_get_static_pad(filter, "src");
+	gst_element_add_pad(bin, gst_ghost_pad_new("src", pad) );
+	gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, countVisFrames, &vis_frames, NULL);
+	gst_object_unref(pad);
+	
+	if (vis_caps) gst_object_unref(GST_OBJECT(vis_caps));
+	vis_caps = GST_ELEMENT(gst_object_ref(filter));
+	updateVisCaps();
+	
+	return bin;
+}
+
+//
+// Function to return the visualizer framerate cap, the user setting or
+// the degradation framerate once that step is taken.  0 means no cap.
+int GST_Interface::visFramerate()
+{
+	if (! (degrade_taken & (1 << 1)) ) return vis_fps;
+	
+	return vis_fps > 0 ? qMin(vis_fps, degrade_vis_fps) : degrade_vis_fps;
+}
+
+//
+// Function to set the visualizer caps from the framerate cap and the size.
+// Without a size set by the user the visualizer renders at the size of the
+// video window, rounded down to window_scale_step so resizing the window
+// only renegotiates once in a while.
+void GST_Interface::updateVisCaps()
+{
+	if (! vis_caps) return;
+	
+	QSize size = vis_size;
+	if (! size.isValid() && ! video_area.isEmpty() )
+		size = QSize(qMax(video_area.width() / window_scale_step, 1) * window_scale_step, qMax(video_area.height() / window_scale_step, 1) * window_scale_step);
+	
+	GstCaps* caps = gst_caps_new_empty_simple("video/x-raw");
+	const int fps = visFramerate();
+	if (fps > 0) gst_caps_set_simple(caps, "framerate", GST_TYPE_FRACTION, fps, 1, NULL);
+	if (size.isValid() ) gst_caps_set_simple(caps, "width", G_TYPE_INT, size.width(), "height", G_TYPE_INT, size.height(), NULL);
+	
+	GstCaps* old = NULL;
+	g_object_get(G_OBJECT(vis_caps), "caps", &old, NULL);
+	if (! old || ! gst_caps_is_equal(old, caps) )
+		g_object_set(G_OBJECT(vis_caps), "caps", caps, NULL);
+	if (old) gst_caps_unref(old);
+	gst_caps_unref(caps);
+	
+	return;
+}
+
+//
+// Function to report the audio output latency.  The latency is what a
+// latency query on the pipeline answers plus the delay the device reports
+// right now for the samples it has queued.  The ring buffer the sink
+// acquired is shown too, that is configuration and not measured.  Return
+// an empty string if no audio sink is running.
+QString GST_Interface::audioOutputInfo()
+{
+	GValue item = G_VALUE_INIT;
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	const gboolean found = gst_iterator_find_custom (it, findAudioSink, &item, NULL);
+	gst_iterator_free (it);
+	if (! found) return QString();
+	
+	QString s;
+	GstAudioBaseSink* sink = GST_AUDIO_BASE_SINK(g_value_get_object(&item));
+	GST_OBJECT_LOCK(sink);
+	GstAudioRingBuffer* rb = sink->ringbuffer ? GST_AUDIO_RING_BUFFER(gst_object_ref(sink->ringbuffer)) : NULL;
+	GST_OBJECT_UNLOCK(sink);
+	
+	if (rb) {
+		const gint rate = GST_AUDIO_INFO_RATE(&rb->spec.info);
+		if (gst_audio_ring_buffer_is_acquired(rb) && rate > 0) {
+			const double buffer_ms = rb->spec.buffer_time / 1000.0;
+			const double device_ms = gst_audio_ring_buffer_delay(rb) * 1000.0 / rate;
+			
+			// latency query, non-live pipelines answer 0
+			gboolean live = FALSE;
+			GstClockTime min_latency = 0;
+			GstQuery* query = gst_query_new_latency();
+			if (gst_element_query(pipeline_playbin, query) )
+				gst_query_parse_latency(query, &live, &min_latency, NULL);
+			gst_query_unref(query);
+			const double query_ms = GST_CLOCK_TIME_IS_VALID(min_latency) ? min_latency / static_cast<double>(GST_MSECOND) : 0.0;
+			
+			s = QString(tr("Audio output %1: latency %2 ms (%3 pipeline %4 ms, device %5 ms), ring buffer %6 ms"))
+				.arg(GST_OBJECT_NAME(sink))
+				.arg(query_ms + device_ms, 0, 'f', 1)
+				.arg(live ? tr("live") : tr("non-live"))
+				.arg(query_ms, 0, 'f', 1)
+				.arg(device_ms, 0, 'f', 1)
+				.arg(buffer_ms, 0, 'f', 1);
+		}
+		gst_object_unref(rb);
+	}	// if rb
+	g_value_unset(&item);
+	
+	return s;
+}
+
+//
+// Function to switch keyframe only decoding on or off.  Decoding and
+// rendering every frame is wasted while nobody can see the video, so when
+// it is hidden do a trick mode seek to the current position.  The demuxer
+// and decoders then pass only keyframes while the audio plays on as usual.
+// Going back is an accurate seek to the current position, so the video
+// picks up exactly where the audio is.  Streams we can't seek in (live
+// streams, most URLs) are left alone, adaptive streams already drop to
+// their lowest variant when the video is hidden.  Not while recording,
+// the file would only get the keyframes.  Hiding is started by hide_timer,
+// showing stops it and only seeks if keyframe only decoding was entered.
+void GST_Interface::setHiddenDecoding(bool hide)
+{
+	if (! hide) hide_timer->stop();
+	if (hide == hidden_decoding) return;
+	if (hide && recorder->isRecording() ) return;
+	if (hide && (streammap.value("n-video") < 1 || ! checkPlayFlag(GST_PLAY_FLAG_VIDEO) || is_live || ! queryStreamSeek()) ) return;
+	if (! hide && getState() < GST_STATE_PAUSED) {
+		hidden_decoding = false;
+		return;
+	}
+	
+	gint64 pos = 0;
+	if (! gst_element_query_position(pipeline_playbin, GST_FORMAT_TIME, &pos) ) return;
+	
+	int seekflags = GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE;
+	if (hide) seekflags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS;
+	if (! gst_element_seek(pipeline_playbin, 1.0, GST_FORMAT_TIME, (GstSeekFlags)(seekflags), GST_SEEK_TYPE_SET, pos, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE) ) {
+		emit signalMessage(MBMP_GI::Application, hide ? tr("The stream did not accept a keyframe only seek, decoding all frames") : tr("Could not seek back to full decoding") );
+		return;
+	}
+	
+	hidden_decoding = hide;
+	emit signalMessage(MBMP_GI::Application, hide ? tr("Video hidden, decoding keyframes only") : tr("Video visible, decoding all frames") );
+	
+	return;
+}
+
+//
+// Function to return the live edge of a timeshifted stream in nanoseconds
+// of stream time.  The stream keeps arriving in real time whatever we do,
+// so the edge is where we started plus the wall clock time since.
+gint64 GST_Interface::timeshiftLiveEdge()
+{
+	return ts_base + ts_clock.elapsed() * GST_MSECOND;
+}
+
+//
+// Function to return the oldest position in nanoseconds we can still shift
+// back to.  That is the start of the recording, or less if the ring has
+// wrapped (measured from the queue2 input rate) or the user limited the
+// timeshift in minutes.
+gint64 GST_Interface::timeshiftStart()
+{
+	const gint64 edge = timeshiftLiveEdge();
+	gint64 start = ts_base;
+	if (ts_secs > 0) start = qMax(start, edge - static_cast<gint64>(ts_secs) * GST_SECOND);
+	
+	GstElement* queue = ts_queue.load();
+	if (queue) {
+		gint64 rate = 0;
+		g_object_get(G_OBJECT(queue), "avg-in-rate", &rate, NULL);
+		if (rate > 0) start = qMax(start, edge - static_cast<gint64>(ts_bytes / rate) * GST_SECOND);
+	}
+	
+	return start;
+}
+
+//
+// Function to forget the timeshift ring buffer of the last stream.  The
+// temp file goes with the queue2.
+void GST_Interface::clearTimeshift()
+{
+	GstElement* queue = ts_queue.fetchAndStoreOrdered(NULL);
+	if (queue) gst_object_unref(queue);
+	ts_base = 0;
+	ts_clock.invalidate();
+	
+	return;
+}
+
+//
+// Function to stop the recording, if there is one.  The file is finished
+// in the background and reported by recordingFinished().
+void GST_Interface::stopRecording()
+{
+	if (! recorder->isRecording() ) return;
+	
+	recorder->stop();
+	emit recordingChanged(false);
+	
+	return;
+}
+
+//
+// Function to return true if the color balance is not adjusted at all
+bool GST_Interface::balanceNeutral()
+{
+	QMap<QString, int>::const_iterator i;
+	for (i = balance.constBegin(); i != balance.constEnd(); ++i) {
+		if (i.value() != 0) return false;
+	}
+	
+	return true;
+}
+
+//
+// Function to apply the color balance to the running pipeline.  Use the
+// video sink's own channels if it does the balance in hardware (no cost),
+// otherwise playbin's channels which are those of the software videobalance
+// it put in.  If there is no videobalance yet the software balance starts
+// with the next stream.  Values from -100 to 100 are mapped onto the
+// channel range, 0 is the middle.  Until the user moves a slider the
+// channels are left alone, a driver's defaults are not always the middle.
+// The method in use is shown in the dialog so the CPU cost is clear.
+void GST_Interface::applyColorBalance()
+{
+	GValue item = G_VALUE_INIT;
+	GstElement* hw = NULL;
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	if (gst_iterator_find_custom (it, findHardwareBalance, &item, NULL) ) {
+		hw = GST_ELEMENT(g_value_dup_object(&item));
+		g_value_unset(&item);
+	}
+	gst_iterator_free (it);
+	
+	GstColorBalance* cb = GST_COLOR_BALANCE(hw ? hw : pipeline_playbin);
+	const GList* channels = gst_color_balance_list_channels(cb);
+	const bool adjust = balance_touched || ! balanceNeutral();
+	for (const GList* l = channels; adjust && l != NULL; l = l->next) {
+		GstColorBalanceChannel* ch = GST_COLOR_BALANCE_CHANNEL(l->data);
+		const QString label = QString(ch->label).toLower();
+		QMap<QString, int>::const_iterator i;
+		for (i = balance.constBegin(); i != balance.constEnd(); ++i) {
+			if (label.contains(i.key()) ) {
+				gst_color_balance_set_value(cb, ch, ch->min_value + static_cast<gint>((static_cast<gint64>(i.value()) + 100) * (ch->max_value - ch->min_value) / 200) );
+				break;
+			}
+		}	// for each of our channels
+	}	// for each element channel
+	
+	QString s;
+	if (hw) 
+		s = QString(tr("Hardware color balance in %1, no CPU cost")).arg(GST_OBJECT_NAME(hw));
+	else if (channels) 
+		s = tr("Software color balance (videobalance), costs CPU on every frame");
+	else if (balanceNeutral() )
+		s = tr("No color balance adjustment");
+	else {
+		s = tr("Software color balance starts with the next stream, it costs CPU on every frame");
+		setPlayFlag(GST_PLAY_FLAG_SOFT_COLORBALANCE, true);
+	}
+	colorbalance->updateMethod(s);
+	
+	if (hw) gst_object_unref(hw);
+	return;
+}
+
+//
+// Function to return true if something draws on the video window, a video
+// stream or the visualizer
+bool GST_Interface::hasVideoOutput()
+{
+	gint n = 0;
+	g_object_get (pipeline_playbin, "n-video", &n, NULL);
+	
+	return (n > 0 && checkPlayFlag(GST_PLAY_FLAG_VIDEO)) || checkPlayFlag(GST_PLAY_FLAG_VIS);
+}
+
+//
+// Function to give back the play flags the audio-only fast path or a
+// hidden video took.  Only call this with the pipeline in the NULL state.
+void GST_Interface::restoreFastPath()
+{
+	if (! fastpath_flags && ! hidden_flags) return;
+	
+	guint flags = 0;
+	g_object_get (pipeline_playbin, "flags", &flags, NULL);
+	g_object_set (pipeline_playbin, "flags", flags | fastpath_flags | hidden_flags, NULL);
+	fastpath_flags = 0;
+	hidden_flags = 0;
+	
+	return;
+}
+
+//
+// Function to drop the video of a URL stream while nobody can see it, the
+// way the audio-only fast path does.  The bitrate limit alone only picks
+// the lowest video variant of an adaptive stream, its audio is usually an
+// alternate rendition and keeps the video coming.  Not while recording,
+// the file would lose its video.  Showing gives the flag back.
+void GST_Interface::setHiddenVideo(bool hide)
+{
+	guint flags = 0;
+	g_object_get (pipeline_playbin, "flags", &flags, NULL);
+	
+	if (hide) {
+		if (hidden_flags || ! checkCurrent(MBMP_GI::Url) || recorder->isRecording() ) return;
+		hidden_flags = flags & GST_PLAY_FLAG_VIDEO;
+		if (! hidden_flags) return;
+		g_object_set (pipeline_playbin, "flags", flags & ~hidden_flags, NULL);
+		emit signalMessage(MBMP_GI::Application, tr("Video hidden, playing the stream without its video") );
+	}
+	else {
+		if (! hidden_flags) return;
+		g_object_set (pipeline_playbin, "flags", flags | hidden_flags, NULL);
+		hidden_flags = 0;
+		emit signalMessage(MBMP_GI::Application, tr("Video visible, playing the video of the stream again") );
+	}
+	
+	return;
+}
+
+//
+// Function to add a QoS message to the statistics of the element that
+// posted it.  Video sinks and decoders post one for each frame they drop
+// or are late with, audio sinks each time they have to resync, which we
+// count as a discontinuity.  Buffer counts are only taken from messages in
+// buffers, audio sinks count samples.
+void GST_Interface::updateQos(GstMessage* msg)
+{
+	GstObject* src = GST_MESSAGE_SRC(msg);
+	if (! src || ! GST_IS_ELEMENT(src) ) return;
+	const QString media = qosMedia(GST_ELEMENT(src));
+	if (media.isEmpty() ) return;
+	
+	QosStats& q = qos_stats[QString(GST_OBJECT_NAME(src))];
+	q.media = media;
+	
+	GstFormat format = GST_FORMAT_UNDEFINED;
+	guint64 processed = 0;
+	guint64 dropped = 0;
+	gst_message_parse_qos_stats (msg, &format, &processed, &dropped);
+	if (format == GST_FORMAT_BUFFERS) {
+		if (processed != G_MAXUINT64) q.processed = qMax(q.processed, processed);
+		if (dropped != G_MAXUINT64) q.dropped = qMax(q.dropped, dropped);
+	}
+	
+	gint64 jitter = 0;
+	gdouble proportion = 1.0;
+	gst_message_parse_qos_values (msg, &jitter, &proportion, NULL);
+	q.jitter_sum += qAbs(jitter) / 1000000.0;
+	++q.messages;
+	q.proportion = qMax(q.proportion, static_cast<double>(proportion) );
+	if (media == "audio") ++q.discont;
+	
+	return;
+}
+
+//
+// Function to decide if a progressive download can sustain playback.  True
+// if the download is finished, the ring buffer is full, or the estimated
+// time to finish the download (plus a 10% margin) is less than the time left
+// to play.  If percent is not NULL it receives the percentage downloaded.
+bool GST_Interface::downloadSustainable(int* percent)
+{
+	GstQuery* query;
+	gint64 estimated_left = -1;
+	gint64 position = 0;
+	gint64 duration = 0;
+	gint fill = 0;
+	gboolean busy = TRUE;
+	
+	query = gst_query_new_buffering (GST_FORMAT_TIME);
+	if (! gst_element_query (pipeline_playbin, query)) {
+		gst_query_unref (query);
+		return false;
+	}
+	gst_query_parse_buffering_percent (query, &busy, &fill);
+	gst_query_parse_buffering_range (query, NULL, NULL, NULL, &estimated_left);
+	gst_query_unref (query);
+	
+	// percentage downloaded, based on the largest estimate we have seen
+	if (estimated_left > dl_maximum) dl_maximum = estimated_left;
+	if (percent != NULL) {
+		if (estimated_left == 0) *percent = 100;
+		else if (dl_maximum > 0 && estimated_left > 0) *percent = static_cast<int>(100 * (dl_maximum - estimated_left) / dl_maximum);
+			else *percent = 0;
+	}	
+	
+	// finished, or the ring buffer is full
+	if (estimated_left == 0 || ! busy) return true;
+	if (estimated_left < 0) return false;
+	
+	// compare download time left to play time left, both in ms
+	if (! gst_element_query_position (pipeline_playbin, GST_FORMAT_TIME, &position) ) return false;
+	if (! gst_element_query_duration (pipeline_playbin, GST_FORMAT_TIME, &duration) || duration <= 0 ) return false;
+	
+	return ( (estimated_left * 11 / 10) < ((duration - position) / GST_MSECOND) );
+}
  
  
 //////////////////////////// Private Slots //////////////////////////
 //
-// Slot to download a file, or most of a file to a buffer.  Called from 
-// ASYNC_DONE case of busHandler. I cannot get the example in chapter
-// 15 of the Gstreamer docs to work.  Anyway, download the entire
-// file before we start playback
+// Slot to monitor a progressive download.  Called every 500ms from dl_timer,
+// which is started from the BUFFERING and ASYNC_DONE cases of busHandler.
+// Playback starts as soon as the estimated download rate can sustain it
+// rather than waiting for the entire file.
 void GST_Interface::downloadBuffer()
 {   
-  // query the pipeline
-  GstQuery* query;        
-  gint64 estimated_left = 0;
-  static gint64 maximum = -1;
   int percent = 0;  
   
-  query = gst_query_new_buffering (GST_FORMAT_BYTES);
-  if (! gst_element_query (pipeline_playbin, query)) return;  
-  
-  gst_query_parse_buffering_range (query, NULL, NULL, NULL, &estimated_left);
-  
-  if (estimated_left == -1) return;;
-  
-  // calculate the percent downloaded
-  if (estimated_left > maximum) maximum = estimated_left;
-  if (maximum != 0 ) {
-    percent = static_cast<int>(100 * (maximum - estimated_left) / maximum);
-  }
-  else
-    percent = 0;
-  
-  if (estimated_left == 0) {
+  if (downloadSustainable(&percent) ) {
     gst_element_set_state(pipeline_playbin, GST_STATE_PLAYING);
     dl_timer->stop();
     is_buffering = false;
-    maximum = -1;
     percent = 100;
   }
 
@@ -1399,3 +3703,152 @@ void GST_Interface::downloadBuffer()
   
   return;
  }
+
+//
+// Slot to close a QoS statistics window, called from qos_timer while a
+// stream is loaded.  For each element the drop ratio, jitter and proportion
+// of the window are computed and shown in StreamInfo, windows with trouble
+// are logged.  When the video crosses the threshold emit qosThreshold() and
+// have the decoders skip frames, once it has been back in step for
+// qos_hold ms clear it again.  With the degradation ladder on frame
+// skipping is one of its steps instead.
+void GST_Interface::checkQos()
+{
+	if (GST_STATE(pipeline_playbin) != GST_STATE_PLAYING) return;
+	
+	GstIterator* it = gst_bin_iterate_recurse (GST_BIN (pipeline_playbin));
+	gst_iterator_foreach (it, qosSinkStats, this);
+	gst_iterator_free (it);
+	
+	double worst = 0.0;
+	double late = 0.0;
+	QStringList sl;
+	sl << QString(tr("Tuning profile: %1")).arg(getTuningProfile() );
+	const QString ao = audioOutputInfo();
+	if (! ao.isEmpty() ) sl << ao;
+	
+	// the visualizer framerate over this window, and the size it renders at
+	const int frames = vis_frames.fetchAndStoreRelaxed(0);
+	if (vis_caps && checkPlayFlag(GST_PLAY_FLAG_VIS) && streammap.value("n-video") < 1) {
+		QString size = "-";
+		GstPad* pad = gst_element_get_static_pad(vis_caps, "src");
+		GstCaps* caps = gst_pad_get_current_caps(pad);
+		gst_object_unref(pad);
+		if (caps) {
+			gint width = 0;
+			gint height = 0;
+			const GstStructure* s = gst_caps_get_structure(caps, 0);
+			if (gst_structure_get_int(s, "width", &width) && gst_structure_get_int(s, "height", &height) ) size = QString("%1x%2").arg(width).arg(height);
+			gst_caps_unref(caps);
+		}
+		const int fps = visFramerate();
+		sl << QString(tr("Visualizer: %1 fps (cap %2) at %3"))
+			.arg(frames * 1000.0 / qos_interval, 0, 'f', 1)
+			.arg(fps > 0 ? QString::number(fps) : QString("-"))
+			.arg(size);
+	}	// if visualizer
+	QMap<QString, QosStats>::iterator i;
+	for (i = qos_stats.begin(); i != qos_stats.end(); ++i) {
+		QosStats& q = i.value();
+		const guint64 dp = q.processed - q.mark_processed;
+		const guint64 dd = q.dropped - q.mark_dropped;
+		q.drop_ratio = (dp + dd) > 0 ? static_cast<double>(dd) / (dp + dd) : 0.0;
+		q.jitter = q.messages > 0 ? q.jitter_sum / q.messages : 0.0;
+		q.last_proportion = q.proportion;
+		
+		QString s = QString(tr("%1 %2: rendered %3, dropped %4 (%5% now), jitter %6 ms, proportion %7"))
+			.arg(q.media)
+			.arg(i.key())
+			.arg(q.processed)
+			.arg(q.dropped)
+			.arg(q.drop_ratio * 100.0, 0, 'f', 1)
+			.arg(q.jitter, 0, 'f', 1)
+			.arg(q.last_proportion > 0.0 ? QString::number(q.last_proportion, 'f', 2) : QString("-") );
+		if (q.media == "audio") s.append(QString(tr(", discontinuities %1")).arg(q.discont) );
+		sl << s;
+		if (dd > 0 || q.messages > 0) emit signalMessage(MBMP_GI::Application, QString(tr("QoS %1")).arg(s) );
+		
+		if (q.media == "video") {
+			worst = qMax(worst, q.drop_ratio);
+			late = qMax(late, q.last_proportion);
+		}
+		
+		// start the next window
+		q.mark_processed = q.processed;
+		q.mark_dropped = q.dropped;
+		q.jitter_sum = 0.0;
+		q.messages = 0;
+		q.proportion = 0.0;
+	}	// for
+	streaminfo->updateQosBox(sl.join("\n") );
+	
+	const bool over = worst > qos_drop_high || late > qos_late_high;
+	const bool under = worst < qos_drop_low && late < qos_late_low;
+	if (! qos_alert && over) {
+		qos_alert = true;
+		alert_timer.start();
+		emit signalMessage(MBMP_GI::Application, QString(tr("QoS threshold crossed: %1% of video frames dropped, proportion %2")).arg(worst * 100.0, 0, 'f', 1).arg(late, 0, 'f', 2) );
+		emit qosThreshold(true);
+		if (! degrade_enabled) setDecoderLoad(true);
+	}
+	else if (qos_alert && under && alert_timer.elapsed() > qos_hold) {
+		qos_alert = false;
+		emit signalMessage(MBMP_GI::Application, tr("QoS back under the threshold") );
+		emit qosThreshold(false);
+		if (! degrade_enabled) setDecoderLoad(false);
+	}
+	
+	// the degradation ladder, one step at a time.  Skip the steps that do
+	// nothing for this stream on the way up.
+	if (! degrade_enabled) return;
+	++degrade_wait;
+	if (under) ++degrade_calm;
+		else degrade_calm = 0;
+	if (over && degrade_level < max_degrade_level && (degrade_level == 0 || degrade_wait >= degrade_step_windows) ) {
+		int next = degrade_level + 1;
+		while (next < max_degrade_level && ! degradeStepUsable(next) ) ++next;
+		if (degradeStepUsable(next) ) setDegradeLevel(next);
+	}
+	else if (degrade_level > 0 && degrade_calm >= degrade_calm_windows) {
+		int prev = degrade_level - 1;
+		while (prev > 0 && ! (degrade_taken & (1 << prev)) ) --prev;
+		setDegradeLevel(prev);
+	}
+	
+	return;
+}
+
+//
+// Slot called when the video has been hidden for hide_delay, switch to
+// keyframe only decoding, or drop the video of a URL stream, if it is
+// still hidden
+void GST_Interface::hideTimeout()
+{
+	if (video_visible) return;
+	
+	setHiddenDecoding(true);
+	setHiddenVideo(true);
+	
+	return;
+}
+
+//
+// Slot to pass a message from the media cache on to the log
+void GST_Interface::cacheMessage(const QString& s)
+{
+	emit signalMessage(MBMP_GI::Application, s);
+	
+	return;
+}
+
+//
+// Slot to report a recording once the recorder has finished its file
+void GST_Interface::recordingFinished(const QString& file, bool ok, const QString& err)
+{
+	if (ok)
+		emit signalMessage(MBMP_GI::Application, tr("Recording saved to %1").arg(file) );
+	else
+		emit signalMessage(MBMP_GI::Warning, tr("Recording to %1 failed: %2").arg(file).arg(err) );
+	
+	return;
+}
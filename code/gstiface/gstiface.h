@@ -29,17 +29,30 @@ DEALINGS IN THE SOFTWARE.
 
 # include <gst/video/navigation.h>
 # include <gst/video/videooverlay.h>
+# include <gst/video/colorbalance.h>
 # include <gst/tag/tag.h>
+# include <gst/audio/audio.h>
 
 # include <QWidget>
 # include <QString>
 # include <QObject>
 # include <QTimer>
+# include <QElapsedTimer>
 # include <QMap>
 # include <QList>
 # include <QVariant>
+# include <QStringList>
+# include <QMutex>
+# include <QRect>
+# include <QSize>
+# include <QAtomicInt>
+# include <QAtomicPointer>
 
 # include "./code/streaminfo/streaminfo.h"
+# include "./code/colorbalance/colorbalance.h"
+# include "./code/profiler/profiler.h"
+# include "./code/mediacache/mediacache.h"
+# include "./code/recorder/recorder.h"
 
 //  Enum's local to this program
 namespace MBMP_GI 
@@ -103,6 +116,35 @@ struct TocEntry
   int end;        // end time (seconds)
 };
 
+//  Structure for a decoder tuning profile, -1 leaves the decoder default
+struct DecoderProfile
+{
+  QStringList factories;  // decoder names, wildcards allowed
+  QString media;          // video or audio
+  int min_height;         // applies to streams at least this high
+  int max_threads;        // max-threads, 0 is one per core
+  int thread_type;        // thread-type flags
+  int skip_frame;         // skip-frame when the decoder can't keep up
+  int queue_mb;           // decodebin queue size in MB
+};
+
+//  Structure for the rolling QoS statistics of one element (sink or decoder)
+struct QosStats
+{
+  QString media;            // video or audio
+  guint64 processed;        // buffers rendered or processed
+  guint64 dropped;          // buffers dropped
+  guint64 mark_processed;   // processed at the start of the window
+  guint64 mark_dropped;     // dropped at the start of the window
+  double drop_ratio;        // fraction of buffers dropped in the last window
+  double jitter_sum;        // sum of |jitter| in ms of the QoS messages this window
+  int messages;             // QoS messages this window
+  double jitter;            // average |jitter| in ms of the last window
+  double proportion;        // largest proportion this window, 0.0 if none
+  double last_proportion;   // largest proportion of the last window
+  int discont;              // audio discontinuities (resyncs)
+};
+
 class GST_Interface : public QObject
 {
   Q_OBJECT
@@ -129,6 +171,35 @@ class GST_Interface : public QObject
     bool queryStreamSeek();
     gint64 queryStreamPosition(); 
     void busHandler(GstMessage*);
+    void elementAdded(GstElement*);
+    void threadEntered(GstMessage*);
+    void threadCaps(GstPad*, GstCaps*);
+    void setDownloadCache(const guint64&, const bool&);
+    void applyAdaptiveLimits(GstElement*);
+    QStringList decoderRanking(const QString&);
+    void chooseVideoSink(GstCaps*);
+    void tuneDecoder(GstElement*, GstCaps*);
+    void applyDecoderLoad(GstElement*);
+    void setDecoderProfiles(const QList<QVariantMap>&);
+    bool setTuningProfile(const QString&);
+    QStringList getTuningProfileList();
+    QString getTuningProfile();
+    void applyTuning(GstElement*);
+    void sampleSinkStats(GstElement*);
+    void setQualityDegradation(bool);
+    void setWindowScaling(bool);
+    void setVisualizerCaps(int, const QSize&);
+    void setProfiling(bool);
+    void setAudioOutput(const QString&, int, int);
+    void setAudioThreadPolicy(const QString&, const QString&);
+    void setTimeshift(const QString&);
+    void setMediaCache(int);
+    void warmUri(const QString&);
+    inline void setRecordDir(const QString& dir) {record_dir = dir;}
+    inline bool isTimeshifting() {return ts_queue.load() != NULL;}
+    inline bool isRecording() {return recorder->isRecording();}
+    bool hasVideoOutput();
+    inline void setAudioOnly(bool b) {audio_only = b;}
      
     // inline function to get private data members
     inline QList<QString> getVisualizerList() {return vismap.keys();}
@@ -149,6 +220,8 @@ class GST_Interface : public QObject
     void mouseNavEvent(QString, int, int, int);
     void keyNavEvent(GstNavigationCommand);
     void seekToPosition(int);
+    void jumpToLive();
+    void toggleRecording(bool);
     void setAudioStream(const int&);
     void setVideoStream(const int&);
     void setTextStream(const int&);
@@ -156,7 +229,14 @@ class GST_Interface : public QObject
     void changeVolume(const double&);
     void changeConnectionSpeed(const guint64&);   
     void playerStop();
+    void setVideoArea(const QSize&, bool);
+    void setRenderRectangle(const QRect&);
+    void exposeVideo();
+    void setDecoderRanking(const QVariantMap&);
     void toggleStreamInfo();
+    void toggleColorBalance();
+    void setColorBalance(const QString&, int);
+    void dumpPipelineGraph();
     // passthrough slots
     inline void cycleAudioStream() {streaminfo->cycleAudioStream();}
     inline void cycleVideoStream() {streaminfo->cycleVideoStream();}
@@ -164,14 +244,25 @@ class GST_Interface : public QObject
 
   signals:
     void signalMessage(int, QString = QString());
+    void qosThreshold(bool);
+    void recordingChanged(bool);
     
   private:
     // members
     GstElement* pipeline_playbin;
     QTimer* dl_timer;
+    QTimer* qos_timer;
+    QTimer* hide_timer;
     QMap<QString, GstElementFactory*> vismap; 
     QMap<QString, int> streammap;
     StreamInfo* streaminfo;   
+    ColorBalance* colorbalance;
+    QMap<QString, int> balance;
+    bool balance_touched;
+    PipelineProfiler* profiler;
+    MediaCache* mediacache;
+    StreamRecorder* recorder;
+    QString record_dir;
     QWidget* mainwidget;
     QList<TocEntry> tracklist;
     QMap<QString, QVariant> map_md_cd;
@@ -180,14 +271,101 @@ class GST_Interface : public QObject
     int mediatype;
     bool is_live;
     bool is_buffering;
+    gint64 dl_maximum;
+    guint64 ringbuffer_size;
+    bool ringbuffer_memory;
+    double bw_in;
+    double bw_out;
+    guint64 bw_applied;
+    gint64 buffer_time;
+    gdouble buffer_high;
+    int stall_level;
+    QElapsedTimer resume_timer;
+    QSize video_area;
+    bool video_visible;
+    guint adaptive_bw;
+    QMutex adaptive_mutex;
+    guint variant_kbps;
+    QMap<QString, QStringList> dec_ranking;
+    QMutex ranking_mutex;
+    QMap<QString, QString> codec_sinks;
+    GstElement* sink_bin;
+    bool sink_chosen;
+    QList<DecoderProfile> dec_profiles;
+    QMutex profile_mutex;
+    bool decoder_loaded;
+    QElapsedTimer alert_timer;
+    int tuning;
+    guint tuning_flags;
+    QMutex tuning_mutex;
+    QMap<QString, QosStats> qos_stats;
+    bool qos_alert;
+    bool degrade_enabled;
+    int degrade_level;
+    int degrade_taken;
+    int degrade_wait;
+    int degrade_calm;
+    GstElementFactory* vis_factory;
+    GstElement* scale_caps;
+    bool window_scaling;
+    GstElement* vis_caps;
+    int vis_fps;
+    QSize vis_size;
+    QAtomicInt vis_frames;
+    QString audio_sink;
+    bool audio_sink_set;
+    gint64 audio_buffer;
+    gint64 audio_latency;
+    bool audio_only;
+    bool hidden_decoding;
+    QRect render_rect;
+    guint fastpath_flags;
+    guint hidden_flags;
+    QAtomicPointer<GstElement> ts_queue;
+    guint64 ts_bytes;
+    int ts_secs;
+    gint64 ts_base;
+    QElapsedTimer ts_clock;
+    int thread_policy;
+    QList<int> thread_cpus;
     
     // functions
     void extractTocTrack(const GstTocEntry*);
     void analyzeStream();
     bool checkCurrent(int);
+    bool downloadSustainable(int* percent = NULL);
+    void updateThroughput(GstMessage*);
+    void tuneBuffering();
+    guint adaptiveBitrateLimit();
+    void updateAdaptiveStats(const GstStructure*);
+    bool findDecoderProfile(const QString&, const QString&, int, DecoderProfile&);
+    void setDecoderLoad(bool);
+    void updateQos(GstMessage*);
+    bool degradeStepUsable(int);
+    void setDegradeLevel(int);
+    GstElement* makeVisualizer(GstElementFactory*);
+    int visFramerate();
+    void updateVisCaps();
+    QString audioOutputInfo();
+    void restoreFastPath();
+    void setHiddenDecoding(bool);
+    void setHiddenVideo(bool);
+    void installScaleFilter();
+    void updateScaleCaps();
+    bool balanceNeutral();
+    void applyColorBalance();
+    gint64 timeshiftLiveEdge();
+    gint64 timeshiftStart();
+    void clearTimeshift();
+    void stopRecording();
+    void boostThread(const QString&, const QString&);
     
     private slots:   
     void downloadBuffer();
+    void checkQos();
+    void hideTimeout();
+    void cacheMessage(const QString&);
+    void recordingFinished(const QString&, bool, const QString&);
 };
     
 # endif   
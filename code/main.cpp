@@ -115,6 +115,57 @@ int main(int argc, char *argv[])
   
   QCommandLineOption blacklistElement(QStringList() << "blacklist", QCoreApplication::translate("main.cpp", "List (comma separated) of GStreamer elements to be blacklisted."), QCoreApplication::translate("main.cpp", "element list"), "" );  
   parser.addOption(blacklistElement);
+  
+  QCommandLineOption cacheSize(QStringList() << "cache-size", QCoreApplication::translate("main.cpp", "Size in MB of the download cache used with download buffering (default is 0 meaning keep the entire file)."), QCoreApplication::translate("main.cpp", "MB"), "0" );  
+  parser.addOption(cacheSize);
+  
+  QCommandLineOption cacheInMemory(QStringList() << "cache-in-memory", QCoreApplication::translate("main.cpp", "Keep the download cache in memory instead of a temporary file (default is a temporary file).") );  
+  parser.addOption(cacheInMemory);
+  
+  QCommandLineOption tuningProfile(QStringList() << "profile", QCoreApplication::translate("main.cpp", "Pipeline tuning profile: default, low-latency, low-memory or high-throughput (default is default)."), QCoreApplication::translate("main.cpp", "profile"), "default" );  
+  parser.addOption(tuningProfile);
+  
+  QCommandLineOption noDegradation(QStringList() << "no-degradation", QCoreApplication::translate("main.cpp", "Disable the automatic quality degradation when the system can't keep up (default is enabled).") );  
+  parser.addOption(noDegradation);
+  
+  QCommandLineOption scaleToWindow(QStringList() << "scale-to-window", QCoreApplication::translate("main.cpp", "Scale video down to the size of the video window before it reaches the video sink (default is off).") );  
+  parser.addOption(scaleToWindow);
+  
+  QCommandLineOption visFps(QStringList() << "vis-fps", QCoreApplication::translate("main.cpp", "Highest framerate the visualizer renders at, 0 for no limit (default is 30)."), QCoreApplication::translate("main.cpp", "fps"), "30" );  
+  parser.addOption(visFps);
+  
+  QCommandLineOption visSize(QStringList() << "vis-size", QCoreApplication::translate("main.cpp", "Size the visualizer renders at (default is the size of the video window)."), QCoreApplication::translate("main.cpp", "WIDTHxHEIGHT"), "" );  
+  parser.addOption(visSize);
+  
+  QCommandLineOption traceProfile(QStringList() << "trace", QCoreApplication::translate("main.cpp", "Profile the pipeline with the GStreamer tracers and show the results in the stream information dialog (default is off).") );  
+  parser.addOption(traceProfile);
+  
+  QCommandLineOption audioSink(QStringList() << "audio-sink", QCoreApplication::translate("main.cpp", "Audio sink element to play through, for instance pulsesink or alsasink (default is the system default)."), QCoreApplication::translate("main.cpp", "element"), "" );  
+  parser.addOption(audioSink);
+  
+  QCommandLineOption audioBuffer(QStringList() << "audio-buffer", QCoreApplication::translate("main.cpp", "Size in milliseconds of the audio sink buffer (default is 0 meaning use the tuning profile)."), QCoreApplication::translate("main.cpp", "ms"), "0" );  
+  parser.addOption(audioBuffer);
+  
+  QCommandLineOption audioLatency(QStringList() << "audio-latency", QCoreApplication::translate("main.cpp", "Size in milliseconds of one audio sink segment, at most half of --audio-buffer (default is 0 meaning half of --audio-buffer)."), QCoreApplication::translate("main.cpp", "ms"), "0" );  
+  parser.addOption(audioLatency);
+  
+  QCommandLineOption audioPriority(QStringList() << "audio-priority", QCoreApplication::translate("main.cpp", "Scheduling of the audio threads, fifo or rr for real-time scheduling, nice for a nice boost (default is to leave them alone)."), QCoreApplication::translate("main.cpp", "policy"), "" );  
+  parser.addOption(audioPriority);
+  
+  QCommandLineOption audioCpus(QStringList() << "audio-cpus", QCoreApplication::translate("main.cpp", "Comma separated list of CPUs to pin the audio threads to (default is any CPU)."), QCoreApplication::translate("main.cpp", "cpus"), "" );  
+  parser.addOption(audioCpus);
+  
+  QCommandLineOption timeShift(QStringList() << "timeshift", QCoreApplication::translate("main.cpp", "Record network streams into a ring buffer so live streams can be paused and rewound. Size is minutes followed by min (30min) or megabytes (500MB) (default is off)."), QCoreApplication::translate("main.cpp", "size"), "" );  
+  parser.addOption(timeShift);
+  
+  QCommandLineOption httpCache(QStringList() << "http-cache", QCoreApplication::translate("main.cpp", "Size in megabytes of the persistent cache for remote media files, replays of cached files are played from disk (default is 0 meaning no cache)."), QCoreApplication::translate("main.cpp", "MB"), "0" );  
+  parser.addOption(httpCache);
+  
+  QCommandLineOption recordDir(QStringList() << "record-dir", QCoreApplication::translate("main.cpp", "Directory to save recordings made while playing in (default is the Music directory, or the Videos directory for streams with video)."), QCoreApplication::translate("main.cpp", "directory"), "" );  
+  parser.addOption(recordDir);
+  
+  QCommandLineOption runBenchmark(QStringList() << "benchmark", QCoreApplication::translate("main.cpp", "Benchmark the video decoders and sinks using the media files in a directory and save the fastest ranking for each codec."), QCoreApplication::translate("main.cpp", "directory"), "" );  
+  parser.addOption(runBenchmark);
     
 	parser.addPositionalArgument("filename", QCoreApplication::translate("main.cpp", "Media file to play."));
   
@@ -0,0 +1,916 @@
+/**************************** mediacache.cpp ***************************
+
+Persistent cache of remote media files, served to GStreamer by a local
+http server
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include "./code/mediacache/mediacache.h"
+# include "./code/resource.h"
+
+# include <QProcessEnvironment>
+# include <QCryptographicHash>
+# include <QDateTime>
+# include <QSettings>
+# include <QStringList>
+# include <QRegExp>
+# include <QUrl>
+# include <QNetworkRequest>
+# include <QHostAddress>
+
+// Constants
+static const qint64 chunk_size = 64 * 1024;				// most bytes moved in one step
+static const qint64 high_water = 512 * 1024;			// stop filling the socket above this
+static const qint64 reply_buffer = 256 * 1024;		// origin bytes Qt may hold for us
+static const int max_request = 16 * 1024;					// longest request header we accept
+static const qint64 warm_size = 512 * 1024;				// bytes fetched ahead for the next item
+static const int max_warmed = 8;									// warmed URLs kept going through the server with the cache off
+static const char* forward_headers[] = {"user-agent", "icy-metadata", "cookie", "referer", NULL};	// client headers the origin gets
+
+/////////////////////////////// CacheEntry ////////////////////////////////
+//
+// Function to return the end of the cached range that holds byte p, or p
+// itself if we don't have that byte
+qint64 CacheEntry::cachedTo(qint64 p) const
+{
+	for (int i = 0; i < ranges.count(); ++i) {
+		if (ranges.at(i).first <= p && p < ranges.at(i).second) return ranges.at(i).second;
+	}
+	
+	return p;
+}
+
+//
+// Function to return the number of bytes we have on disk
+qint64 CacheEntry::cachedBytes() const
+{
+	qint64 n = 0;
+	for (int i = 0; i < ranges.count(); ++i) {
+		n += ranges.at(i).second - ranges.at(i).first;
+	}
+	
+	return n;
+}
+
+//
+// Function to add the bytes from a up to b to the cached ranges, merging
+// ranges that touch or overlap
+void CacheEntry::addRange(qint64 a, qint64 b)
+{
+	if (b <= a) return;
+	
+	QList<QPair<qint64, qint64> > merged;
+	bool placed = false;
+	for (int i = 0; i < ranges.count(); ++i) {
+		const QPair<qint64, qint64>& r = ranges.at(i);
+		if (r.second < a) merged.append(r);
+		else if (b < r.first) {
+			if (! placed) {merged.append(qMakePair(a, b)); placed = true;}
+			merged.append(r);
+		}
+			else {
+				a = qMin(a, r.first);
+				b = qMax(b, r.second);
+			}
+	}	// for
+	if (! placed) merged.append(qMakePair(a, b));
+	ranges = merged;
+	
+	return;
+}
+
+/////////////////////////// MediaCacheConnection //////////////////////////
+//
+// Constructor
+MediaCacheConnection::MediaCacheConnection(QTcpSocket* s, MediaCacheWorker* w) : QObject(w)
+{
+	worker = w;
+	socket = s;
+	socket->setParent(this);
+	reply = NULL;
+	request.clear();
+	client_headers.clear();
+	origin_headers.clear();
+	key.clear();
+	pos = 0;
+	last = -1;
+	reply_pos = 0;
+	has_range = false;
+	headers_sent = false;
+	origin_seen = false;
+	started = false;
+	
+	connect (socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+	connect (socket, SIGNAL(bytesWritten(qint64)), this, SLOT(pump()));
+	connect (socket, SIGNAL(disconnected()), this, SLOT(clientGone()));
+}
+
+// Destructor
+MediaCacheConnection::~MediaCacheConnection()
+{
+	closeOrigin();
+}
+
+//////////////////////////// Private Functions ////////////////////////////
+//
+// Function to return our cache entry, NULL if the worker doesn't know it
+CacheEntry* MediaCacheConnection::entry()
+{
+	return worker->entry(key);
+}
+
+//
+// Function to start serving once the request is read.  If we know the
+// size we can answer right away, otherwise the headers wait for the origin.
+void MediaCacheConnection::start()
+{
+	CacheEntry* e = entry();
+	if (! e) {
+		sendError(404, "Not Found");
+		return;
+	}
+	
+	started = true;
+	++e->users;
+	e->atime = QDateTime::currentDateTime().toTime_t();
+	file.setFileName(worker->dataFile(key) );
+	file.open(QIODevice::ReadWrite);
+	
+	if (e->size >= 0) {
+		if (pos >= e->size) {
+			sendError(416, "Range Not Satisfiable");
+			return;
+		}
+		if (last < 0 || last >= e->size) last = e->size - 1;
+		sendHeaders();
+		pump();
+	}
+	else 
+		openOrigin();
+	
+	return;
+}
+
+//
+// Function to send the response headers for pos to last
+void MediaCacheConnection::sendHeaders()
+{
+	CacheEntry* e = entry();
+	QByteArray h;
+	
+	if (e->size >= 0 && e->cacheable) {
+		h.append(has_range ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n");
+		h.append("Accept-Ranges: bytes\r\n");
+		h.append(QString("Content-Length: %1\r\n").arg(last - pos + 1).toLatin1() );
+		if (has_range) h.append(QString("Content-Range: bytes %1-%2/%3\r\n").arg(pos).arg(last).arg(e->size).toLatin1() );
+	}
+	else
+		h.append("HTTP/1.1 200 OK\r\n");
+	if (! e->type.isEmpty() ) h.append(QString("Content-Type: %1\r\n").arg(e->type).toLatin1() );
+	for (int i = 0; i < origin_headers.count(); ++i) {
+		h.append(origin_headers.at(i).first + ": " + origin_headers.at(i).second + "\r\n");
+	}
+	h.append("Connection: close\r\n\r\n");
+	
+	socket->write(h);
+	headers_sent = true;
+	
+	return;
+}
+
+//
+// Function to answer with an error and close the connection
+void MediaCacheConnection::sendError(int code, const QString& text)
+{
+	closeOrigin();
+	if (! headers_sent) {
+		socket->write(QString("HTTP/1.1 %1 %2\r\nContent-Length: 0\r\nConnection: close\r\n\r\n").arg(code).arg(text).toLatin1() );
+		headers_sent = true;
+	}
+	socket->disconnectFromHost();
+	
+	return;
+}
+
+//
+// Function to request the rest of the file from pos on from the origin
+// server.  If-Range makes the server send the whole (new) file instead of
+// the range if it has changed since we cached it.  The client headers the
+// origin may care about (User-Agent, Icy-MetaData, cookies) go with it.
+void MediaCacheConnection::openOrigin()
+{
+	CacheEntry* e = entry();
+	closeOrigin();
+	
+	QNetworkRequest req(QUrl(e->url) );
+	for (int i = 0; i < client_headers.count(); ++i) {
+		req.setRawHeader(client_headers.at(i).first, client_headers.at(i).second);
+	}
+	req.setRawHeader("Range", QString("bytes=%1-").arg(pos).toLatin1() );
+	if (! e->etag.isEmpty() ) req.setRawHeader("If-Range", e->etag.toLatin1() );
+	else if (! e->modified.isEmpty() ) req.setRawHeader("If-Range", e->modified.toLatin1() );
+	#if QT_VERSION >= 0x050600
+		req.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+	# endif
+	
+	reply = worker->network()->get(req);
+	reply->setReadBufferSize(reply_buffer);
+	reply_pos = pos;
+	origin_seen = false;
+	connect (reply, SIGNAL(metaDataChanged()), this, SLOT(originHeaders()));
+	connect (reply, SIGNAL(readyRead()), this, SLOT(pump()));
+	connect (reply, SIGNAL(finished()), this, SLOT(originFinished()));
+	
+	emit worker->message(QString(tr("Media cache: fetching %1 from byte %2")).arg(e->url).arg(pos) );
+	return;
+}
+
+//
+// Function to drop the origin request
+void MediaCacheConnection::closeOrigin()
+{
+	if (! reply) return;
+	
+	reply->disconnect(this);
+	reply->abort();
+	reply->deleteLater();
+	reply = NULL;
+	
+	return;
+}
+
+////////////////////////////// Private Slots //////////////////////////////
+//
+// Slot to read the request from the GStreamer source.  Only GET and a
+// single "bytes=a-" or "bytes=a-b" range are understood, which is all
+// souphttpsrc sends.  The headers in forward_headers are kept for the
+// origin request.
+void MediaCacheConnection::readRequest()
+{
+	if (started || headers_sent) {
+		socket->readAll();
+		return;
+	}
+	
+	request.append(socket->readAll() );
+	if (! request.contains("\r\n\r\n") ) {
+		if (request.size() > max_request) sendError(400, "Bad Request");
+		return;
+	}
+	
+	const QStringList lines = QString::fromLatin1(request).split("\r\n");
+	const QStringList first = lines.at(0).split(' ');
+	if (first.count() < 2 || first.at(0) != "GET") {
+		sendError(405, "Method Not Allowed");
+		return;
+	}
+	key = first.at(1).section('/', 1, 1);
+	
+	QRegExp rx("^range:\\s*bytes=(\\d+)-(\\d*)", Qt::CaseInsensitive);
+	for (int i = 1; i < lines.count(); ++i) {
+		if (rx.indexIn(lines.at(i)) == 0) {
+			has_range = true;
+			pos = rx.cap(1).toLongLong();
+			if (! rx.cap(2).isEmpty() ) last = rx.cap(2).toLongLong();
+			continue;
+		}
+		const QString name = lines.at(i).section(':', 0, 0).trimmed();
+		for (int j = 0; forward_headers[j] != NULL; ++j) {
+			if (name.toLower() == forward_headers[j])
+				client_headers.append(qMakePair(name.toLatin1(), lines.at(i).section(':', 1).trimmed().toLatin1()) );
+		}
+	}	// for
+	
+	start();
+	return;
+}
+
+//
+// Slot to move data to the socket until it holds high_water bytes.  Data
+// comes from the cache file where we have it and from the origin where we
+// don't.  Origin data is written to the cache file as it passes.  Called
+// whenever the socket has written something or the origin has new data.
+void MediaCacheConnection::pump()
+{
+	CacheEntry* e = entry();
+	if (! e || ! headers_sent) return;
+	
+	while (socket->state() == QAbstractSocket::ConnectedState && socket->bytesToWrite() < high_water) {
+		if (last >= 0 && pos > last) {
+			closeOrigin();
+			socket->disconnectFromHost();
+			return;
+		}
+		const qint64 want = (last >= 0) ? qMin(chunk_size, last + 1 - pos) : chunk_size;
+		QByteArray data;
+		
+		// origin data, either bytes before pos the server sent anyway (it
+		// ignored our range) which we only cache, or the bytes at pos
+		if (reply && origin_seen && reply_pos <= pos) {
+			data = reply->read(reply_pos < pos ? qMin(chunk_size, pos - reply_pos) : want);
+			if (data.isEmpty() ) {
+				if (! reply->isFinished() ) return;
+				const bool failed = (reply->error() != QNetworkReply::NoError);
+				closeOrigin();
+				if (failed || ! e->cacheable) {
+					socket->disconnectFromHost();
+					return;
+				}
+				continue;
+			}	// if no data
+			if (e->cacheable && worker->storing() && file.isOpen() && file.seek(reply_pos) && file.write(data) == data.size() )
+				e->addRange(reply_pos, reply_pos + data.size() );
+			const bool behind = (reply_pos < pos);
+			reply_pos += data.size();
+			if (behind) continue;
+		}
+		
+		// cache data
+		else if (e->cacheable && e->cachedTo(pos) > pos) {
+			if (reply && reply_pos > pos) closeOrigin();
+			if (file.seek(pos) ) data = file.read(qMin(want, e->cachedTo(pos) - pos) );
+			if (data.isEmpty() ) {
+				sendError(500, "Internal Server Error");
+				return;
+			}
+		}
+		
+		// nothing here yet, ask the origin and wait for it
+			else {
+				if (reply && origin_seen) closeOrigin();
+				if (! reply) openOrigin();
+				return;
+			}
+		
+		socket->write(data);
+		pos += data.size();
+	}	// while
+	
+	return;
+}
+
+//
+// Slot to check the origin response.  A 206 continues at reply_pos, a 200
+// starts at byte 0 either because the file changed (If-Range failed) or
+// because the server does not do ranges.  A changed file invalidates what
+// we have.  A response without a length is a live stream, we pass it
+// through without caching.  So is an internet radio stream with inline
+// metadata, its icy- headers go on to the client.
+void MediaCacheConnection::originHeaders()
+{
+	if (! reply || origin_seen) return;
+	const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (status == 0 || (status >= 300 && status < 400) ) return;
+	
+	CacheEntry* e = entry();
+	if (status != 200 && status != 206) {
+		emit worker->message(QString(tr("Media cache: origin answered %1 for %2")).arg(status).arg(e->url) );
+		sendError(502, "Bad Gateway");
+		return;
+	}
+	origin_seen = true;
+	
+	origin_headers.clear();
+	const QList<QByteArray> names = reply->rawHeaderList();
+	for (int i = 0; i < names.count(); ++i) {
+		if (names.at(i).toLower().startsWith("icy-") ) origin_headers.append(qMakePair(names.at(i), reply->rawHeader(names.at(i))) );
+	}
+	
+	// the total size of the file
+	qint64 total = -1;
+	if (status == 206) {
+		QRegExp rx("bytes\\s+(\\d+)-\\d+/(\\d+)");
+		if (rx.indexIn(QString::fromLatin1(reply->rawHeader("Content-Range")) ) >= 0) {
+			reply_pos = rx.cap(1).toLongLong();
+			total = rx.cap(2).toLongLong();
+		}
+	}
+	else {
+		reply_pos = 0;
+		if (reply->header(QNetworkRequest::ContentLengthHeader).isValid() )
+			total = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+	}
+	
+	// has it changed since we cached it
+	const QString etag = QString::fromLatin1(reply->rawHeader("ETag") );
+	const QString modified = QString::fromLatin1(reply->rawHeader("Last-Modified") );
+	const qint64 old_size = e->size;
+	bool changed = (old_size >= 0 && total >= 0 && total != old_size);
+	if (! etag.isEmpty() && ! e->etag.isEmpty() && etag != e->etag) changed = true;
+	else if (etag.isEmpty() && ! modified.isEmpty() && ! e->modified.isEmpty() && modified != e->modified) changed = true;
+	if (changed) {
+		worker->invalidate(key);
+		emit worker->message(QString(tr("Media cache: %1 changed on the server, cache dropped")).arg(e->url) );
+		// the client was told the old size
+		if (headers_sent && total != old_size) {
+			sendError(502, "Bad Gateway");
+			return;
+		}
+	}
+	
+	e->etag = etag;
+	e->modified = modified;
+	e->type = reply->header(QNetworkRequest::ContentTypeHeader).toString();
+	if (total > 0) e->size = total;
+	else if (e->size < 0) e->cacheable = false;
+	if (reply->hasRawHeader("icy-metaint") ) e->cacheable = false;
+	
+	if (! headers_sent) {
+		if (e->size >= 0) {
+			if (pos >= e->size) {
+				sendError(416, "Range Not Satisfiable");
+				return;
+			}
+			if (last < 0 || last >= e->size) last = e->size - 1;
+		}
+		sendHeaders();
+	}
+	
+	pump();
+	return;
+}
+
+//
+// Slot called when the origin request is done
+void MediaCacheConnection::originFinished()
+{
+	if (! reply) return;
+	
+	if (reply->error() != QNetworkReply::NoError && reply->error() != QNetworkReply::OperationCanceledError) {
+		emit worker->message(QString(tr("Media cache: network error %1")).arg(reply->errorString()) );
+		if (! headers_sent) {
+			sendError(502, "Bad Gateway");
+			return;
+		}
+	}
+	
+	pump();
+	return;
+}
+
+//
+// Slot called when the GStreamer source closes the connection, after a
+// seek or at the end of the stream
+void MediaCacheConnection::clientGone()
+{
+	closeOrigin();
+	file.close();
+	if (started) worker->release(key);
+	started = false;
+	this->deleteLater();
+	
+	return;
+}
+
+///////////////////////////// MediaCacheWorker ////////////////////////////
+//
+// Constructor
+MediaCacheWorker::MediaCacheWorker(const QDir& dir) : QObject()
+{
+	server = NULL;
+	nam = NULL;
+	warmer = NULL;
+	head = NULL;
+	head_key.clear();
+	entries.clear();
+	cache_dir = dir;
+	budget = 0;
+}
+
+// Destructor
+MediaCacheWorker::~MediaCacheWorker()
+{
+	QMap<QString, CacheEntry>::const_iterator i;
+	for (i = entries.constBegin(); i != entries.constEnd(); ++i) {
+		writeEntry(i.key() );
+	}
+}
+
+//////////////////////////// Public Functions /////////////////////////////
+//
+// Function to drop everything we have for k, the server has a new version
+void MediaCacheWorker::invalidate(const QString& k)
+{
+	CacheEntry* e = entry(k);
+	if (! e) return;
+	
+	e->size = -1;
+	e->etag.clear();
+	e->modified.clear();
+	e->ranges.clear();
+	QFile::resize(dataFile(k), 0);
+	
+	return;
+}
+
+//
+// Function called when a connection is done with k.  Save what we have
+// and keep the cache inside the budget.
+void MediaCacheWorker::release(const QString& k)
+{
+	CacheEntry* e = entry(k);
+	if (! e) return;
+	
+	e->users = qMax(e->users - 1, 0);
+	e->atime = QDateTime::currentDateTime().toTime_t();
+	if (e->isComplete() && e->users == 0)
+		emit message(QString(tr("Media cache: %1 is fully cached (%2 MB)")).arg(e->url).arg(e->size / (1024 * 1024)) );
+	writeEntry(k);
+	evict();
+	
+	return;
+}
+
+////////////////////////////// Public Slots ///////////////////////////////
+//
+// Slot to start the local server, runs in the worker thread.  Return the
+// port we listen on, 0 if we could not.
+int MediaCacheWorker::start()
+{
+	if (server) return server->serverPort();
+	
+	server = new QTcpServer(this);
+	nam = new QNetworkAccessManager(this);
+	connect (server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+	if (! server->listen(QHostAddress::LocalHost, 0) ) {
+		emit message(QString(tr("Media cache: could not start the local server, %1")).arg(server->errorString()) );
+		return 0;
+	}
+	
+	readIndex();
+	return server->serverPort();
+}
+
+//
+// Slot to make a URL known under key k.  The entry is about to be played
+// so it becomes the most recently used, a connection closing in between
+// must not evict it.
+void MediaCacheWorker::registerUrl(const QString& k, const QString& url)
+{
+	const qint64 now = QDateTime::currentDateTime().toTime_t();
+	if (entries.contains(k) && entries.value(k).url == url) {
+		entries[k].atime = now;
+		return;
+	}
+	
+	CacheEntry e;
+	e.url = url;
+	e.atime = now;
+	entries[k] = e;
+	QFile::remove(dataFile(k) );
+	
+	return;
+}
+
+//
+// Slot to set the most bytes we keep on disk
+void MediaCacheWorker::setBudget(qint64 bytes)
+{
+	budget = bytes;
+	evict();
+	
+	return;
+}
+
+//
+// Slot to get ready for url (key k) before it is played.  The network
+// manager opens the connection now, including the TLS handshake, and keeps
+// it for the request the proxy makes later.  If we don't know the size yet
+// that is done with a HEAD request, which also tells us the size.  Then
+// warmRange() reads the start of the file.
+void MediaCacheWorker::warm(const QString& k, const QString& url)
+{
+	if (! server) return;
+	registerUrl(k, url);
+	const CacheEntry* e = entry(k);
+	
+	const QUrl u(url);
+	if (e->size < 0 && e->cacheable && ! head) {
+		QNetworkRequest req(u);
+		#if QT_VERSION >= 0x050600
+			req.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+		# endif
+		head = nam->head(req);
+		head_key = k;
+		connect (head, SIGNAL(finished()), this, SLOT(headFinished()));
+		return;
+	}
+	
+	# ifndef QT_NO_SSL
+		if (u.scheme().toLower() == "https") nam->connectToHostEncrypted(u.host(), u.port(443) );
+		else
+	# endif
+			nam->connectToHost(u.host(), u.port(80) );
+	warmRange(k);
+	
+	return;
+}
+
+///////////////////////////// Private Functions ///////////////////////////
+//
+// Function to read the start of the file for k through our own server,
+// which puts it in the cache like any other read, so the first buffer
+// comes from disk.  That needs the cache on and a known size, an entry
+// without one may be a live stream whose bytes would only be thrown away.
+void MediaCacheWorker::warmRange(const QString& k)
+{
+	const CacheEntry* e = entry(k);
+	if (! e || ! storing() || warmer || e->size < 0 || ! e->cacheable || e->isComplete() || e->cachedTo(0) >= warm_size) return;
+	
+	warmer = new QTcpSocket(this);
+	connect (warmer, SIGNAL(readyRead()), this, SLOT(warmerRead()));
+	connect (warmer, SIGNAL(disconnected()), this, SLOT(warmerGone()));
+	connect (warmer, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(warmerGone()));
+	warmer->connectToHost(QHostAddress::LocalHost, server->serverPort() );
+	warmer->write(QString("GET /%1/warm HTTP/1.1\r\nHost: 127.0.0.1\r\nRange: bytes=0-%2\r\nConnection: close\r\n\r\n").arg(k).arg(warm_size - 1).toLatin1() );
+	
+	emit message(QString(tr("Media cache: warming up %1")).arg(e->url) );
+	return;
+}
+
+//
+// Function to read the cache index
+void MediaCacheWorker::readIndex()
+{
+	QSettings index(cache_dir.absoluteFilePath("index.ini"), QSettings::IniFormat);
+	const QStringList keys = index.childGroups();
+	for (int i = 0; i < keys.count(); ++i) {
+		index.beginGroup(keys.at(i) );
+		CacheEntry e;
+		e.url = index.value("url").toString();
+		e.size = index.value("size", -1).toLongLong();
+		e.etag = index.value("etag").toString();
+		e.modified = index.value("modified").toString();
+		e.type = index.value("type").toString();
+		e.atime = index.value("atime").toLongLong();
+		const QStringList sl = index.value("ranges").toString().split(',', QString::SkipEmptyParts);
+		for (int j = 0; j < sl.count(); ++j) {
+			e.addRange(sl.at(j).section('-', 0, 0).toLongLong(), sl.at(j).section('-', 1, 1).toLongLong() );
+		}
+		index.endGroup();
+		
+		// a data file that went away takes its entry with it
+		if (e.url.isEmpty() || ! QFile::exists(dataFile(keys.at(i))) ) {
+			index.remove(keys.at(i) );
+			QFile::remove(dataFile(keys.at(i)) );
+		}
+		else 
+			entries[keys.at(i)] = e;
+	}	// for
+	
+	return;
+}
+
+//
+// Function to write the entry for k to the index.  Streams we don't
+// cache are removed.
+void MediaCacheWorker::writeEntry(const QString& k)
+{
+	QSettings index(cache_dir.absoluteFilePath("index.ini"), QSettings::IniFormat);
+	const CacheEntry e = entries.value(k);
+	
+	if (! e.cacheable || e.ranges.isEmpty() ) {
+		index.remove(k);
+		QFile::remove(dataFile(k) );
+		return;
+	}
+	
+	QStringList sl;
+	for (int i = 0; i < e.ranges.count(); ++i) {
+		sl << QString("%1-%2").arg(e.ranges.at(i).first).arg(e.ranges.at(i).second);
+	}
+	index.beginGroup(k);
+	index.setValue("url", e.url);
+	index.setValue("size", e.size);
+	index.setValue("etag", e.etag);
+	index.setValue("modified", e.modified);
+	index.setValue("type", e.type);
+	index.setValue("atime", e.atime);
+	index.setValue("ranges", sl.join(",") );
+	index.endGroup();
+	
+	return;
+}
+
+//
+// Function to remove the least recently used entries until the cache
+// fits the budget.  Entries being read are never removed.
+void MediaCacheWorker::evict()
+{
+	if (budget <= 0) return;
+	
+	qint64 total = 0;
+	QMap<QString, CacheEntry>::const_iterator i;
+	for (i = entries.constBegin(); i != entries.constEnd(); ++i) {
+		total += i.value().cachedBytes();
+	}
+	
+	while (total > budget) {
+		QString oldest;
+		for (i = entries.constBegin(); i != entries.constEnd(); ++i) {
+			if (i.value().users > 0 || i.value().ranges.isEmpty() ) continue;
+			if (oldest.isEmpty() || i.value().atime < entries.value(oldest).atime) oldest = i.key();
+		}
+		if (oldest.isEmpty() ) break;
+		
+		total -= entries.value(oldest).cachedBytes();
+		emit message(QString(tr("Media cache: evicted %1")).arg(entries.value(oldest).url) );
+		QSettings index(cache_dir.absoluteFilePath("index.ini"), QSettings::IniFormat);
+		index.remove(oldest);
+		QFile::remove(dataFile(oldest) );
+		entries.remove(oldest);
+	}	// while
+	
+	return;
+}
+
+////////////////////////////// Private Slots //////////////////////////////
+//
+// Slot to take a new connection from a GStreamer source
+void MediaCacheWorker::newConnection()
+{
+	while (server->hasPendingConnections() ) {
+		new MediaCacheConnection(server->nextPendingConnection(), this);
+	}
+	
+	return;
+}
+
+//
+// Slot called when the HEAD request of a warm up is done.  A 200 with a
+// length gives us the size and validators, then the start of the file can
+// be read.  Anything else (servers that refuse HEAD, live streams) leaves
+// the entry alone, the connection is open either way.
+void MediaCacheWorker::headFinished()
+{
+	if (! head) return;
+	QNetworkReply* r = head;
+	head = NULL;
+	
+	CacheEntry* e = entry(head_key);
+	const int status = r->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (e && e->size < 0 && r->error() == QNetworkReply::NoError && status == 200 && ! r->hasRawHeader("icy-metaint") &&
+		r->header(QNetworkRequest::ContentLengthHeader).isValid() && r->header(QNetworkRequest::ContentLengthHeader).toLongLong() > 0) {
+			e->size = r->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+			e->etag = QString::fromLatin1(r->rawHeader("ETag") );
+			e->modified = QString::fromLatin1(r->rawHeader("Last-Modified") );
+			e->type = r->header(QNetworkRequest::ContentTypeHeader).toString();
+	}
+	r->deleteLater();
+	
+	warmRange(head_key);
+	return;
+}
+
+//
+// Slot to throw away what the warm up read brings, it is already in the
+// cache file
+void MediaCacheWorker::warmerRead()
+{
+	if (warmer) warmer->readAll();
+	
+	return;
+}
+
+//
+// Slot called when the warm up read is done or failed
+void MediaCacheWorker::warmerGone()
+{
+	if (! warmer || sender() != warmer) return;
+	
+	warmer->disconnect(this);
+	warmer->deleteLater();
+	warmer = NULL;
+	
+	return;
+}
+
+/////////////////////////////// MediaCache ////////////////////////////////
+//
+// Constructor
+MediaCache::MediaCache(QObject* parent) : QObject(parent)
+{
+	port = 0;
+	budget = 0;
+	
+	// the cache directory
+	QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+	QDir dir(QString(env.value("XDG_CACHE_HOME", QString(QDir::homePath()) + "/.cache") + "/%1/media").arg(QString(APP).toLower()) );
+	if (! dir.exists() ) dir.mkpath(dir.absolutePath() );
+	
+	// the worker and its server run in their own thread so they keep
+	// serving while the GUI thread waits on the pipeline
+	thread = new QThread(this);
+	worker = new MediaCacheWorker(dir);
+	worker->moveToThread(thread);
+	connect (thread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+	connect (worker, SIGNAL(message(QString)), this, SIGNAL(message(QString)));
+}
+
+// Destructor
+MediaCache::~MediaCache()
+{
+	thread->quit();
+	thread->wait();
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to set the cache size in megabytes, 0 turns the cache off.  The
+// server is started the first time the cache is turned on.
+void MediaCache::setBudget(int mb)
+{
+	budget = qMax(mb, 0);
+	if (! thread->isRunning() && budget == 0) return;
+	
+	startServer();
+	QMetaObject::invokeMethod(worker, "setBudget", Qt::QueuedConnection, Q_ARG(qint64, static_cast<qint64>(budget) * 1024 * 1024) );
+	
+	return;
+}
+
+//
+// Function to return the URI to give playbin for url.  http and https
+// files go through our local server if the cache is on or we warmed them
+// up, anything else (other schemes, playlists, adaptive manifests whose
+// relative URIs would point at us) is returned unchanged.
+QString MediaCache::localUri(const QString& url)
+{
+	const QString k = keyOf(url);
+	if (k.isEmpty() || port == 0 || (! isEnabled() && ! warmed.contains(k)) ) return url;
+	
+	QMetaObject::invokeMethod(worker, "registerUrl", Qt::BlockingQueuedConnection, Q_ARG(QString, k), Q_ARG(QString, url) );
+	
+	// keep the file name so anything that looks at the extension still can
+	return QString("http://127.0.0.1:%1/%2/%3").arg(port).arg(k).arg(QString(QUrl::toPercentEncoding(QUrl(url).fileName())) );
+}
+
+//
+// Function to warm up url, the item expected to play next.  The server is
+// started for it even with the cache off, url is then passed through it
+// without being stored so the request reuses the connection we opened.
+// Does nothing for anything localUri() would not send through the server.
+void MediaCache::warm(const QString& url)
+{
+	const QString k = keyOf(url);
+	if (k.isEmpty() || ! startServer() ) return;
+	warmed.removeAll(k);
+	warmed.append(k);
+	while (warmed.count() > max_warmed) warmed.removeFirst();
+	
+	QMetaObject::invokeMethod(worker, "warm", Qt::QueuedConnection, Q_ARG(QString, k), Q_ARG(QString, url) );
+	
+	return;
+}
+
+//////////////////////////// Private Functions ////////////////////////////
+//
+// Function to start the worker thread and its server if they are not
+// running yet.  Return true if the server is listening.
+bool MediaCache::startServer()
+{
+	if (! thread->isRunning() ) {
+		thread->start();
+		QMetaObject::invokeMethod(worker, "start", Qt::BlockingQueuedConnection, Q_RETURN_ARG(int, port) );
+	}
+	
+	return port > 0;
+}
+
+//
+// Function to return the cache key for url, or an empty string if url is
+// not something we send through the server
+QString MediaCache::keyOf(const QString& url)
+{
+	
+	const QUrl u(url);
+	if (u.scheme().toLower() != "http" && u.scheme().toLower() != "https") return QString();
+	const QString path = u.path().toLower();
+	const QStringList skip = QStringList() << ".m3u8" << ".m3u" << ".pls" << ".mpd" << ".ism" << ".xspf" << ".asx";
+	for (int i = 0; i < skip.count(); ++i) {
+		if (path.endsWith(skip.at(i)) ) return QString();
+	}
+	
+	return QString(QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5).toHex() );
+}
@@ -0,0 +1,198 @@
+/**************************** mediacache.h *****************************
+
+Persistent cache of remote media files, served to GStreamer by a local
+http server
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef MEDIACACHE_H
+# define MEDIACACHE_H
+
+# include <QObject>
+# include <QThread>
+# include <QString>
+# include <QStringList>
+# include <QList>
+# include <QPair>
+# include <QMap>
+# include <QDir>
+# include <QFile>
+# include <QByteArray>
+# include <QTcpServer>
+# include <QTcpSocket>
+# include <QNetworkAccessManager>
+# include <QNetworkReply>
+
+//	One cached URL.  ranges are the byte ranges we have on disk, start
+//	inclusive and end exclusive, sorted and never overlapping.
+struct CacheEntry
+{
+	QString url;				// the remote URL
+	qint64 size;				// size of the remote file, -1 if not known yet
+	QString etag;				// ETag the server sent
+	QString modified;		// Last-Modified the server sent
+	QString type;				// Content-Type the server sent
+	QList<QPair<qint64, qint64> > ranges;
+	qint64 atime;				// last access, seconds since the epoch
+	int users;					// connections reading this entry now
+	bool cacheable;			// false for streams without a length
+	
+	CacheEntry() : size(-1), atime(0), users(0), cacheable(true) {}
+	qint64 cachedTo(qint64) const;
+	qint64 cachedBytes() const;
+	void addRange(qint64, qint64);
+	inline bool isComplete() const {return size > 0 && cachedTo(0) >= size;}
+};
+
+class MediaCacheWorker;
+
+//	One connection from a GStreamer http source.  Serves the requested range
+//	from the cache file where we have it and from the origin server where we
+//	don't, writing what comes from the origin into the cache file.
+class MediaCacheConnection : public QObject
+{
+	Q_OBJECT
+	
+	public:
+		MediaCacheConnection(QTcpSocket*, MediaCacheWorker*);
+		~MediaCacheConnection();
+	
+	private:
+	// members
+		MediaCacheWorker* worker;
+		QTcpSocket* socket;
+		QNetworkReply* reply;
+		QFile file;
+		QByteArray request;
+		QList<QPair<QByteArray, QByteArray> > client_headers;
+		QList<QPair<QByteArray, QByteArray> > origin_headers;
+		QString key;
+		qint64 pos;
+		qint64 last;
+		qint64 reply_pos;
+		bool has_range;
+		bool headers_sent;
+		bool origin_seen;
+		bool started;
+	
+	// functions
+		CacheEntry* entry();
+		void start();
+		void sendHeaders();
+		void sendError(int, const QString&);
+		void openOrigin();
+		void closeOrigin();
+	
+	private slots:
+		void readRequest();
+		void pump();
+		void originHeaders();
+		void originFinished();
+		void clientGone();
+};
+
+//	Worker class, lives in its own thread and runs the local http server
+//	the GStreamer http source reads from.  Only MediaCache should use this.
+class MediaCacheWorker : public QObject
+{
+	Q_OBJECT
+	
+	public:
+		MediaCacheWorker(const QDir&);
+		~MediaCacheWorker();
+		inline QNetworkAccessManager* network() {return nam;}
+		inline QString dataFile(const QString& k) {return cache_dir.absoluteFilePath(k + ".data");}
+		inline CacheEntry* entry(const QString& k) {return entries.contains(k) ? &entries[k] : NULL;}
+		inline bool storing() {return budget > 0;}
+		void invalidate(const QString&);
+		void release(const QString&);
+	
+	public slots:
+		int start();
+		void registerUrl(const QString&, const QString&);
+		void setBudget(qint64);
+		void warm(const QString&, const QString&);
+		
+	signals:
+		void message(const QString&);
+	
+	private:
+	// members
+		QTcpServer* server;
+		QNetworkAccessManager* nam;
+		QTcpSocket* warmer;
+		QNetworkReply* head;
+		QString head_key;
+		QMap<QString, CacheEntry> entries;
+		QDir cache_dir;
+		qint64 budget;
+	
+	// functions
+		void readIndex();
+		void writeEntry(const QString&);
+		void evict();
+		void warmRange(const QString&);
+	
+	private slots:
+		void newConnection();
+		void headFinished();
+		void warmerRead();
+		void warmerGone();
+};
+
+//	Class to keep a persistent cache of remote media files.  http and https
+//	URLs are played through a local server that serves what we already
+//	have from disk, so a replay of a fully cached file makes no network
+//	request at all.  With the cache off the server still passes the URLs
+//	we warmed up through, so they get the connection opened for them.
+class MediaCache : public QObject
+{
+	Q_OBJECT
+	
+	public:
+		MediaCache(QObject*);
+		~MediaCache();
+		
+		void setBudget(int);
+		QString localUri(const QString&);
+		void warm(const QString&);
+		inline bool isEnabled() {return budget > 0 && port > 0;}
+		
+	signals:
+		void message(const QString&);
+	
+	private:
+	// members
+		QThread* thread;
+		MediaCacheWorker* worker;
+		int port;
+		int budget;
+		QStringList warmed;
+	
+	// functions
+		bool startServer();
+		QString keyOf(const QString&);
+};
+
+# endif
@@ -70,6 +70,12 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	mpris2 = new Mpris2(this);
 	pos_timer = new QTimer(this);
 	albumart = new ArtWidget(this);
+	thumbnailer = new Thumbnailer(this);
+	decbench = new DecoderBenchmark(this);
+	resolver = new UrlResolver(this);
+	pending_url.clear();
+	b_next_warmed = false;
+	thumb_popup = new QLabel(this, Qt::ToolTip);
 	
 	// Create the notifyclient, make four tries; first immediately in constructor, then
   // at 1/2 second, 2 seconds and finally at 8 seconds
@@ -122,6 +128,8 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	ui.actionSeekFrwd60->setIcon(iconman.getIcon("forward_60"));
 	ui.actionSeekBack600->setIcon(iconman.getIcon("back_600"));
 	ui.actionSeekFrwd600->setIcon(iconman.getIcon("forward_600"));
+	ui.actionJumpToLive->setIcon(iconman.getIcon("jump_live"));
+	ui.actionRecord->setIcon(iconman.getIcon("record"));
 	ui.actionPlayerStop->setIcon(iconman.getIcon("player_stop"));
 	ui.actionVolumeDecreaseStep->setIcon(iconman.getIcon("volume_step_down"));
 	ui.actionVolumeIncreaseStep->setIcon(iconman.getIcon("volume_step_up"));
@@ -140,12 +148,17 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	// hide the buffering progress bar
 	ui.progressBar_buffering->hide();	
 	
+	// track the mouse over the position slider for the seek preview
+	ui.horizontalSlider_position->setMouseTracking(true);
+	thumb_popup->hide();
+	
 	// set up an event filter 
 	QList<QWidget*> childlist = ui.widget_control->findChildren<QWidget*>();
 	childlist += playlist->findChildren<QWidget*>();
 	for (int i = 0; i < childlist.count(); ++i) {
 		childlist.at(i)->installEventFilter(this);
 	}	
+	videowidget->installEventFilter(this);
 	
 	// find the the optical drives, or at least the first five
 	for (int i = 0; i < 5; ++i) {
@@ -215,6 +228,69 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	}			
 	if (ok) gstiface->changeConnectionSpeed(cnxnspeed);		
 	
+	// setup the download cache, a ring buffer of cachesize MB.  Only used
+	// when download buffering is enabled.
+	quint64 cachesize = 0;
+	bool b_cachemem = false;
+	if (parser.isSet("cache-size") ) 
+		cachesize = parser.value("cache-size").toUInt();
+	else if (diag_settings->useStartOptions() )
+		cachesize = diag_settings->getSetting("StartOptions", "ring_buffer_size").toUInt();
+	if (parser.isSet("cache-in-memory") )
+		b_cachemem = true;
+	else if (diag_settings->useStartOptions() )
+		b_cachemem = diag_settings->getSetting("StartOptions", "ring_buffer_in_memory").toBool();
+	gstiface->setDownloadCache(cachesize, b_cachemem);
+	
+	// setup the audio output stage, sink and buffer sizes in ms
+	QString audiosink;
+	int audiobuffer = 0;
+	int audiolatency = 0;
+	if (parser.isSet("audio-sink") )
+		audiosink = parser.value("audio-sink");
+	else if (diag_settings->useStartOptions() )
+		audiosink = diag_settings->getSetting("StartOptions", "audio_sink").toString();
+	if (parser.isSet("audio-buffer") )
+		audiobuffer = parser.value("audio-buffer").toInt();
+	else if (diag_settings->useStartOptions() )
+		audiobuffer = diag_settings->getSetting("StartOptions", "audio_buffer_time").toInt();
+	if (parser.isSet("audio-latency") )
+		audiolatency = parser.value("audio-latency").toInt();
+	else if (diag_settings->useStartOptions() )
+		audiolatency = diag_settings->getSetting("StartOptions", "audio_latency_time").toInt();
+	gstiface->setAudioOutput(audiosink, audiobuffer, audiolatency);
+	
+	// scheduling and CPU pinning of the audio threads
+	QString audiopriority;
+	QString audiocpus;
+	if (parser.isSet("audio-priority") )
+		audiopriority = parser.value("audio-priority");
+	else if (diag_settings->useStartOptions() )
+		audiopriority = diag_settings->getSetting("StartOptions", "audio_priority").toString();
+	if (parser.isSet("audio-cpus") )
+		audiocpus = parser.value("audio-cpus");
+	else if (diag_settings->useStartOptions() )
+		audiocpus = diag_settings->getSetting("StartOptions", "audio_cpus").toString();
+	gstiface->setAudioThreadPolicy(audiopriority, audiocpus);
+	
+	// timeshift ring buffer for network streams, in minutes or MB
+	if (parser.isSet("timeshift") )
+		gstiface->setTimeshift(parser.value("timeshift") );
+	else if (diag_settings->useStartOptions() )
+		gstiface->setTimeshift(diag_settings->getSetting("StartOptions", "timeshift").toString() );
+	
+	// persistent cache for remote media files, size in MB
+	if (parser.isSet("http-cache") )
+		gstiface->setMediaCache(parser.value("http-cache").toInt() );
+	else if (diag_settings->useStartOptions() )
+		gstiface->setMediaCache(diag_settings->getSetting("StartOptions", "http_cache_size").toInt() );
+	
+	// where recordings go, empty for the XDG music or videos directory
+	if (parser.isSet("record-dir") )
+		gstiface->setRecordDir(parser.value("record-dir") );
+	else if (diag_settings->useStartOptions() )
+		gstiface->setRecordDir(diag_settings->getSetting("StartOptions", "record_dir").toString() );
+	
   // Assign actions defined in the UI to toolbuttons.  This also has the
   // effect of adding actions to this dialog so shortcuts work provided
   // the toolbutton is visible.  Since we can hide GUI in this widget
@@ -272,6 +348,8 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	this->ui.toolButton_back600->setDefaultAction(ui.actionSeekBack600);	
 	this->addAction(ui.actionSeekFrwd600);
 	this->ui.toolButton_frwd600->setDefaultAction(ui.actionSeekFrwd600);
+	this->addAction(ui.actionJumpToLive);
+	this->addAction(ui.actionRecord);
 	this->addAction(ui.actionAdvancedMenu);
 	this->addAction(ui.actionAVSync);
 	this->addAction(ui.actionColorBalance);
@@ -400,6 +478,32 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 		else b_01 = false;		
 	gstiface->setPlayFlag(GST_PLAY_FLAG_DOWNLOAD, b_01);
 	action_dbuf->setChecked(b_01);	
+	
+	// the tuning profile submenu.  A profile sets the buffering flags so
+	// apply it last and sync the buffering actions to what it did
+	QString profile = parser.value("profile");
+	if (! parser.isSet("profile") && diag_settings->useStartOptions() && ! diag_settings->getSetting("StartOptions", "tuning_profile").toString().isEmpty() )
+		profile = diag_settings->getSetting("StartOptions", "tuning_profile").toString();
+	if (! gstiface->setTuningProfile(profile) ) gstiface->setTuningProfile("default");
+	action_sbuf->setChecked(gstiface->checkPlayFlag(GST_PLAY_FLAG_BUFFERING) );
+	action_dbuf->setChecked(gstiface->checkPlayFlag(GST_PLAY_FLAG_DOWNLOAD) );
+	
+	action_prof = options_menu->addAction(tr("Pipeline Profiling"));
+	action_prof->setCheckable(true);
+	b_01 = parser.isSet("trace");
+	if (b_01) gstiface->setProfiling(true);
+	action_prof->setChecked(b_01);
+	
+	options_menu->addSeparator();
+	profile_menu = options_menu->addMenu(tr("Tuning Profile"));
+	profile_group = new QActionGroup(this);
+	QStringList profilelist = gstiface->getTuningProfileList();
+	for (int i = 0; i < profilelist.size(); ++i) {
+		QAction* act = profile_menu->addAction(profilelist.at(i));
+		act->setCheckable(true);
+		profile_group->addAction(act);
+		if (profilelist.at(i) == gstiface->getTuningProfile() ) act->setChecked(true);
+	}
 
 	// create the control_menu
 	control_menu = new QMenu(this);
@@ -429,6 +533,8 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	control_menu->addAction(ui.actionSeekFrwd10);
 	control_menu->addAction(ui.actionSeekFrwd60);	
 	control_menu->addAction(ui.actionSeekFrwd600);
+	control_menu->addAction(ui.actionJumpToLive);
+	control_menu->addAction(ui.actionRecord);
 	control_menu->addSeparator();	
 	control_menu->addAction(ui.actionPlaylistFirst);
 	control_menu->addAction(ui.actionPlaylistBack);	
@@ -478,6 +584,8 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	ui.actionSeekFrwd60->setShortcuts(scman.getKeySequence("cmd_seek_frwd_60"));
 	ui.actionSeekBack600->setShortcuts(scman.getKeySequence("cmd_seek_back_600"));
 	ui.actionSeekFrwd600->setShortcuts(scman.getKeySequence("cmd_seek_frwd_600"));
+	ui.actionJumpToLive->setShortcuts(scman.getKeySequence("cmd_jump_live"));
+	ui.actionRecord->setShortcuts(scman.getKeySequence("cmd_record"));
 	ui.actionAdvancedMenu->setShortcuts(scman.getKeySequence("cmd_advanced_menu"));
 	ui.actionAVSync->setShortcuts(scman.getKeySequence("cmd_av_sync"));
 	ui.actionColorBalance->setShortcuts(scman.getKeySequence("cmd_color_bal"));
@@ -518,6 +626,10 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
   // connect signals to slots 
   connect (stackedwidget_group, SIGNAL (triggered(QAction*)), this, SLOT(advanceStackedWidget(QAction*)));	
   connect (ui.actionToggleStreamInfo, SIGNAL (triggered()), gstiface, SLOT(toggleStreamInfo()));
+  connect (ui.actionColorBalance, SIGNAL (triggered()), gstiface, SLOT(toggleColorBalance()));
+  connect (ui.actionJumpToLive, SIGNAL (triggered()), gstiface, SLOT(jumpToLive()));
+  connect (ui.actionRecord, SIGNAL (triggered(bool)), gstiface, SLOT(toggleRecording(bool)));
+  connect (gstiface, SIGNAL (recordingChanged(bool)), ui.actionRecord, SLOT(setChecked(bool)));
 	connect (ui.actionQuit, SIGNAL (triggered()), qApp, SLOT(quit()));
 	connect (ui.actionToggleGUI, SIGNAL (triggered()), this, SLOT(toggleGUI()));
 	connect (ui.actionToggleShade, SIGNAL (triggered()), this, SLOT(toggleShadeMode()));
@@ -548,10 +660,18 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	connect (ui.actionAudioCD, SIGNAL (triggered()), this, SLOT(initializeCD()));
 	connect (ui.actionDVD, SIGNAL (triggered()), this, SLOT(initializeDVD()));
 	connect (videowidget, SIGNAL(navsignal(QString,int,int,int)), gstiface, SLOT(mouseNavEvent(QString,int,int,int)));
+	connect (videowidget, SIGNAL(renderRectChanged(QRect)), gstiface, SLOT(setRenderRectangle(QRect)));
+	connect (videowidget, SIGNAL(renderRectChanged(QRect)), this, SLOT(updateVideoArea()));
+	connect (videowidget, SIGNAL(exposeRequested()), gstiface, SLOT(exposeVideo()));
 	connect (options_menu, SIGNAL(triggered(QAction*)), this, SLOT(changeOptions(QAction*)));
 	connect (qApp, SIGNAL(aboutToQuit()), this, SLOT(cleanUp()));
 	connect (pos_timer, SIGNAL(timeout()), this, SLOT(setPositionWidgets()));
 	connect (playlist, SIGNAL(artworkRetrieved()), this, SLOT(artworkRetrieved()));
+	connect (thumbnailer, SIGNAL(thumbnailReady(int, QImage)), this, SLOT(showThumbnail(int, QImage)));
+	connect (resolver, SIGNAL(resolved(QString, QString)), this, SLOT(urlResolved(QString, QString)));
+	connect (resolver, SIGNAL(failed(QString, QString)), this, SLOT(urlFailed(QString, QString)));
+	connect (decbench, SIGNAL(signalMessage(int, QString)), this, SLOT(processGstifaceMessages(int, QString)));
+	connect (decbench, SIGNAL(rankingReady(QVariantMap)), gstiface, SLOT(setDecoderRanking(QVariantMap)));
 	
 	connect (mpris2, SIGNAL(applicationStop()), qApp, SLOT(quit()));
 	connect (mpris2, SIGNAL(controlStop()), ui.actionPlayerStop, SLOT(trigger()));
@@ -703,6 +823,41 @@ PlayerControl::PlayerControl(const QCommandLineParser& parser, QWidget* parent)
 	else if (diag_settings->useStartOptions() && diag_settings->getSetting("StartOptions", "no_hardware_decoding").toBool() )  b_01=false;
 	gstiface->hardwareDecoding(b_01);	
 	
+	// degrade quality step by step when the system can't keep up
+	b_01 = true;
+	if (parser.isSet("no-degradation") ) b_01 = false;
+	else if (diag_settings->useStartOptions() && diag_settings->getSetting("StartOptions", "no_quality_degradation").toBool() ) b_01 = false;
+	gstiface->setQualityDegradation(b_01);
+	
+	// scale the video down to the window size before the sink
+	b_01 = false;
+	if (parser.isSet("scale-to-window") ) b_01 = true;
+	else if (diag_settings->useStartOptions() && diag_settings->getSetting("StartOptions", "scale_to_window").toBool() ) b_01 = true;
+	if (b_01) gstiface->setWindowScaling(b_01);
+	
+	// visualizer framerate cap and size, WIDTHxHEIGHT or empty for the size 
+	// of the video window
+	int visfps = parser.value("vis-fps").toInt();
+	QString vissize = parser.value("vis-size");
+	if (! parser.isSet("vis-fps") && diag_settings->useStartOptions() && diag_settings->getSetting("StartOptions", "vis_framerate").isValid() )
+		visfps = diag_settings->getSetting("StartOptions", "vis_framerate").toInt();
+	if (! parser.isSet("vis-size") && diag_settings->useStartOptions() )
+		vissize = diag_settings->getSetting("StartOptions", "vis_size").toString();
+	QSize vsize;
+	if (vissize.contains('x', Qt::CaseInsensitive) )
+		vsize = QSize(vissize.section('x', 0, 0, QString::SectionCaseInsensitiveSeps).toInt(), vissize.section('x', 1, 1, QString::SectionCaseInsensitiveSeps).toInt() );
+	gstiface->setVisualizerCaps(visfps, vsize);
+	
+	// decoder threading and queue profiles from the settings file
+	gstiface->setDecoderProfiles(diag_settings->getDecoderProfiles() );
+	
+	// Decoder and video sink ranking.  A benchmark requested on the command
+	// line runs now, otherwise use the saved ranking.  Both run in the
+	// background and apply the ranking when it is ready.  A benchmark the
+	// saved ranking needs waits for playback to stop.
+	if (parser.isSet("benchmark") ) decbench->start(parser.value("benchmark") );
+		else decbench->restore();
+	
 	// wait 10ms (basically give the constructor time to end) and then
 	// start the media playback
 	QTimer::singleShot(10, this, SLOT(playMedia()));
@@ -731,6 +886,9 @@ void PlayerControl::setPositionWidgets()
 	// mili * 1000 = full seconds
 	qint64 position = gstiface->queryStreamPosition();
 	
+	// the live edge of a timeshifted stream keeps moving
+	if (gstiface->isTimeshifting() ) setDurationWidgets(gstiface->queryDuration() / (1000 * 1000 * 1000), gstiface->queryStreamSeek() );
+	
 	// position is zero or positive
 	if (position >= 0 ) {
 		QTime t(0,0,0);
@@ -739,6 +897,13 @@ void PlayerControl::setPositionWidgets()
 		ui.label_position->setText(t.toString("HH:mm:ss") );
 		ui.horizontalSlider_position->setSliderPosition(pos);	
 		mpris2->setPosition(position);
+		
+		// Connections the server dropped while this item played are opened
+		// again just before the end so the track change does not wait on them
+		if (! b_next_warmed && ui.horizontalSlider_position->maximum() > 0 && ui.horizontalSlider_position->maximum() - pos <= 10) {
+			b_next_warmed = true;
+			this->prefetchNext();
+		}
 	}
 	// position is negative
 	else {
@@ -762,6 +927,55 @@ void PlayerControl::artworkRetrieved()
 	return;
 }
 
+//
+// Slot to play a URL youtube-dl has resolved.  Called from a resolver
+// signal.  Ignored unless it is the item we are still waiting to play.
+void PlayerControl::urlResolved(const QString& url, const QString& media)
+{
+	if (url != pending_url || url != playlist->getCurrentUri() ) return;
+	pending_url.clear();
+	
+	gstiface->playMedia(videowidget->winId(), media);
+	this->changeVolume(ui.dial_volume->value());
+	this->prefetchNext();
+	
+	return;
+}
+
+//
+// Slot called when youtube-dl could not resolve a URL we want to play
+void PlayerControl::urlFailed(const QString& url, const QString& reason)
+{
+	if (url != pending_url) return;
+	pending_url.clear();
+	
+	this->processGstifaceMessages(MBMP_GI::Info, tr("Failed processing %1 through youtube-dl (%2). Skipping URL").arg(url).arg(reason) );
+	
+	return;
+}
+
+//
+// Slot to show a seek preview above the position slider.  Called from
+// a thumbnailer signal.  secs is the stream position of the image.
+void PlayerControl::showThumbnail(int secs, const QImage& img)
+{
+	(void) secs;
+	
+	// the mouse may have left while the frame was being extracted
+	if (! ui.horizontalSlider_position->underMouse() ) return;
+	
+	thumb_popup->setPixmap(QPixmap::fromImage(img) );
+	thumb_popup->adjustSize();
+	
+	// center the popup over the cursor, just above the slider
+	QPoint p = ui.horizontalSlider_position->mapFromGlobal(QCursor::pos() );
+	p = ui.horizontalSlider_position->mapToGlobal(QPoint(p.x(), 0) );
+	thumb_popup->move(p.x() - thumb_popup->width() / 2, p.y() - thumb_popup->height() - 4);
+	thumb_popup->show();
+	
+	return;
+}
+
 ////////////////////////////// Public Slots ////////////////////////////
 //
 //	Slot to change the volume in gstiface in response to the volume dial being changed
@@ -874,8 +1088,11 @@ void PlayerControl::playMedia(QAction* act)
 	}
 	
 	// Make sure playpause is checked, a double click in the playlist will
-	// come here directly so handle that case
+	// come here directly so handle that case. Forget any URL still waiting
+	// on youtube-dl, we've moved on.
 	ui.actionPlayPause->setChecked(true);
+	pending_url.clear();
+	b_next_warmed = false;
 		
 	// If we are playing a CD send the track to gstiface.  This is only if
 	// we change tracks in the playlist.  Initially playing is started directly
@@ -892,16 +1109,18 @@ void PlayerControl::playMedia(QAction* act)
 	}
 	
 	// If we are playing a URL process it through youtube-dl if requested and if the URL has a default port
-	// youtube-dl does not like URL's when the port is specified.
+	// youtube-dl does not like URL's when the port is specified.  A cached result plays right away,
+	// otherwise the resolver runs youtube-dl in the background and urlResolved() starts playing.
 	else if (playlist->currentItemType() == MBMP_PL::Url) {
 		if (diag_settings->useYouTubeDL() && QUrl::fromUserInput(playlist->getCurrentUri()).port() == -1 ) {
-			QProcess p;
-			p.start(QString("youtube-dl -g -f best %1").arg(playlist->getCurrentUri()) );
-			if (p.waitForFinished(diag_settings->getYouTubeDLTimeout() * 1000) )	// timeout from settings
-				gstiface->playMedia(videowidget->winId(), p.readAll());
+			QString media;
+			if (resolver->lookup(playlist->getCurrentUri(), media) ) {
+				gstiface->playMedia(videowidget->winId(), media);
+			}
 			else {
-				this->processGstifaceMessages(MBMP_GI::Info, tr("Failed processing %1 through youtube-dl. Skipping URL").arg(playlist->getCurrentUri()) );
-				return;
+				pending_url = playlist->getCurrentUri();
+				resolver->setTimeout(diag_settings->getYouTubeDLTimeout() );	// timeout from settings
+				resolver->resolve(pending_url);
 			}	// else
 		}	// if useYouTubeDL
 		
@@ -912,9 +1131,13 @@ void PlayerControl::playMedia(QAction* act)
 
 	else {
 		// Get the window ID to render the media on and the next item in 
-		// the playlist, then send both to gstiface to play the media
-		if (playlist->currentIsPlayable() ) 
+		// the playlist, then send both to gstiface to play the media.  Tell
+		// gstiface if the discoverer found only audio so it can skip the 
+		// video and subtitle chains.
+		if (playlist->currentIsPlayable() ) {
+			gstiface->setAudioOnly(playlist->currentIsAudioOnly() );
 			gstiface->playMedia(videowidget->winId(), playlist->getCurrentUri());	
+		}
 	}	// else
 	
 	// Set the stream volume to agree with the dial
@@ -923,6 +1146,9 @@ void PlayerControl::playMedia(QAction* act)
 	// start the position timer
 	pos_timer->start(500);
 	
+	// get the next item ready if it is on the network
+	this->prefetchNext();
+	
 	// set the album art page.
 	albumart->setInfo(playlist->getAlbumArt(), playlist->getCurrentTitle(), playlist->getCurrentArtist() );
 	
@@ -957,6 +1183,9 @@ void PlayerControl::stopPlaying()
 	// Let gstiface know about it, this will set the playerstate to NULL
 	gstiface->playerStop();	
 	
+	// a benchmark put off at startup can have the decoders now
+	decbench->runPending();
+	
 	// If we were playing a disk
 	if (b_disk) {
 		playlist->clearPlaylist();
@@ -973,6 +1202,10 @@ void PlayerControl::stopPlaying()
 	ui.progressBar_buffering->hide();
 	ui.progressBar_buffering->setValue(0);
 	
+	// Forget the seek preview images
+	thumbnailer->clear();
+	thumb_popup->hide();
+	
 	// Restore Display Power Message Signaling
 	if (playlist->getCurrentRow() < 0) return;
 	Display* dpy = XOpenDisplay(NULL);
@@ -1329,8 +1562,13 @@ void PlayerControl::processGstifaceMessages(int mtype, QString msg)
 				// initialize things based on player state	
 				if (msg.contains("PAUSED to PLAYING", Qt::CaseSensitive) ) {
 					this->setDurationWidgets(gstiface->queryDuration() / (1000 * 1000 * 1000), gstiface->queryStreamSeek() ); 
+					if (gstiface->currentIsFile() )
+						thumbnailer->setMedia(playlist->getCurrentUri(), gstiface->queryDuration() / (1000 * 1000 * 1000) );
 				}	// if PAUSED to PLAYING
 		
+				// the video sink draws on the videowidget from PAUSED on
+				videowidget->setVideoActive(gstiface->getState() >= GST_STATE_PAUSED && gstiface->hasVideoOutput() );
+				
 				// let mpris2 know about state changes	
 				mpris2->setState(gstiface->getState() );
 				mpris2->setCanSeek(gstiface->queryStreamSeek() );	
@@ -1585,6 +1823,17 @@ void PlayerControl::changeOptions(QAction* act)
 		gstiface->setPlayFlag(GST_PLAY_FLAG_DOWNLOAD, act->isChecked() );
 	}	
 	
+	else if (act == action_prof) {
+		gstiface->setProfiling(act->isChecked() );
+	}
+	
+	// a tuning profile, it may change the buffering flags
+	else if (act->actionGroup() == profile_group) {
+		gstiface->setTuningProfile(opt);
+		action_sbuf->setChecked(gstiface->checkPlayFlag(GST_PLAY_FLAG_BUFFERING) );
+		action_dbuf->setChecked(gstiface->checkPlayFlag(GST_PLAY_FLAG_DOWNLOAD) );
+	}
+	
 	return;
 }
 
@@ -1674,6 +1923,7 @@ void PlayerControl::setDurationWidgets(int duration, bool seek_enabled)
 		}
 		else 
 			seek_group->setEnabled(seek_enabled);
+		ui.actionJumpToLive->setEnabled(gstiface->isTimeshifting() );
 	}
 	// duration is negative, for instance we just stopped the stream,
 	else {
@@ -1683,6 +1933,7 @@ void PlayerControl::setDurationWidgets(int duration, bool seek_enabled)
 		ui.horizontalSlider_position->setSliderPosition(0); 
 		ui.horizontalSlider_position->setEnabled(false);
 		seek_group->setEnabled(false);
+		ui.actionJumpToLive->setEnabled(false);
 	}
 		
 	return;	
@@ -1718,6 +1969,33 @@ bool PlayerControl::eventFilter(QObject* watched, QEvent* event)
 			return false;
 	}	// if
 	
+	// Seek preview when hovering over the position slider. Only for streams
+	// with video, the thumbnailer ignores anything that is not a local file.
+	if (watched == ui.horizontalSlider_position && event->type() == QEvent::MouseMove) {
+		if (ui.horizontalSlider_position->isEnabled() && thumbnailer->isActive() && gstiface->getStreamMap().value("n-video") > 0) {
+			QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+			thumbnailer->requestThumbnail(QStyle::sliderValueFromPosition(
+				ui.horizontalSlider_position->minimum(),
+				ui.horizontalSlider_position->maximum(),
+				mouseEvent->x(),
+				ui.horizontalSlider_position->width()) );
+		}	// if active
+		return false;
+	}	// if
+	
+	if (watched == ui.horizontalSlider_position && event->type() == QEvent::Leave) {
+		thumb_popup->hide();
+		return false;
+	}	// if
+	
+	// Keep GST_Interface informed about the visibility of the video window,
+	// adaptive streams use it to pick a variant.  Size changes come from the
+	// videowidget renderRectChanged signal, throttled during a resize.
+	if (watched == videowidget && (event->type() == QEvent::Show || event->type() == QEvent::Hide) ) {
+		this->updateVideoArea();
+		return false;
+	}	// if
+	
 	// Disable tooltips on control box Allow playlistitem tooltips, except disable
 	// if the checkBox_showInfo is checked
 	if (event->type() == QEvent::ToolTip) {
@@ -1739,6 +2017,16 @@ bool PlayerControl::eventFilter(QObject* watched, QEvent* event)
 	return false;
 }
 
+//
+// Minimizing or restoring the window changes what can be seen of the video
+void PlayerControl::changeEvent(QEvent* event)
+{
+	if (event->type() == QEvent::WindowStateChange) this->updateVideoArea();
+	
+	QDialog::changeEvent(event);
+	return;
+}
+
 ////////////////////////////// Private Functions ////////////////////////////
 //
 //	Function to read the text contained in a file.  Input is a const char* to 
@@ -1876,3 +2164,41 @@ void PlayerControl::processMediaInfo(const QString& msg)
 			
 	return;
 }
+
+//
+// Function to get the next playlist item ready if it is a URL so pressing
+// Next (or reaching the end of this one) does not wait on it.  URLs for
+// youtube-dl are resolved first, the media URL is warmed up once we have
+// it.  Everything else is warmed up in gstiface right away.
+void PlayerControl::prefetchNext()
+{
+	const QString next = playlist->getNextUrl();
+	if (next.isEmpty() ) return;
+	
+	if (diag_settings->useYouTubeDL() && QUrl::fromUserInput(next).port() == -1 ) {
+		QString media;
+		if (resolver->lookup(next, media) )
+			gstiface->warmUri(media);
+		else {
+			resolver->setTimeout(diag_settings->getYouTubeDLTimeout() );
+			resolver->prefetch(next);
+		}	// else
+	}	// if useYouTubeDL
+	
+	else
+		gstiface->warmUri(next);
+	
+	return;
+}
+
+//
+// Function to send the video window size (in device pixels) and whether
+// it can be seen to GST_Interface.  The video can't be seen if another
+// page of the stackedwidget is showing, in shade mode or when minimized.
+void PlayerControl::updateVideoArea()
+{
+	const bool visible = videowidget->isVisible() && stackedwidget->currentWidget() == videowidget && ! this->isMinimized();
+	gstiface->setVideoArea(videowidget->size() * videowidget->devicePixelRatio(), visible);
+	
+	return;
+}
@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 # include <QMessageBox>
 # include <QTimer>
 # include <QStackedWidget>
+# include <QLabel>
+# include <QImage>
 
 # include "ui_playerctl.h"
 
@@ -51,6 +53,9 @@ DEALINGS IN THE SOFTWARE.
 # include "./code/notify/notify.h"
 # include "./code/ipc/mpris2.h"
 # include "./code/artwidget/artwidget.h"
+# include "./code/thumbnailer/thumbnailer.h"
+# include "./code/decbench/decbench.h"
+# include "./code/urlresolver/urlresolver.h"
 
 // To toggle DPMS.  Note that Xlib.h defines a macro Bool, and QT also defines
 // Bool in QMetaData. Need to undefine the X11 version - be careful using
@@ -102,10 +107,15 @@ class PlayerControl : public QDialog
     void setDurationWidgets(int, bool seek_enabled = false);
     void setPositionWidgets();
     void artworkRetrieved();
+    void showThumbnail(int, const QImage&);
+    void updateVideoArea();
+    void urlResolved(const QString&, const QString&);
+    void urlFailed(const QString&, const QString&);
 
 	protected:
 		void contextMenuEvent(QContextMenuEvent*);		
 		bool eventFilter(QObject*, QEvent*);
+		void changeEvent(QEvent*);
 	
   private:
   // mbmp members 
@@ -122,6 +132,10 @@ class PlayerControl : public QDialog
     bool b_logtofile;
     short displaymode;
     ArtWidget* albumart;
+    Thumbnailer* thumbnailer;
+    QLabel* thumb_popup;
+    DecoderBenchmark* decbench;
+    UrlResolver* resolver;
  
   // plain members 
 		QActionGroup* playlist_group;    
@@ -130,10 +144,12 @@ class PlayerControl : public QDialog
 		QActionGroup* dvd_group;
 		QActionGroup* vis_group;
 		QActionGroup* stackedwidget_group;
+		QActionGroup* profile_group;
 		QMenu* control_menu;
 		QMenu* vis_menu;
 		QMenu* advanced_menu;
 		QMenu* options_menu;
+		QMenu* profile_menu;
 		QCursor ncurs;
 		QFile logfile;
 		int loglevel;
@@ -141,7 +157,10 @@ class PlayerControl : public QDialog
 		QAction* action_sub;
 		QAction* action_sbuf;
 		QAction* action_dbuf;
+		QAction* action_prof;
 		int hiatus_resume;
+		QString pending_url;
+		bool b_next_warmed;
 		CARD16 dpms_power_level;
 		BOOL dpms_state;
 		int xss_timeout_return;
@@ -152,6 +171,7 @@ class PlayerControl : public QDialog
   // functions
 		QString readTextFile(const char*);
 		void processMediaInfo(const QString&);
+		void prefetchNext();
 
 };
 
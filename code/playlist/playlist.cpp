@@ -89,6 +89,9 @@ Playlist::Playlist(QWidget* parent)
   
   // Initialize musicbrainz manager
   mbman = NULL;
+  
+  // Background prober to fill in URL items
+  urlprober = new UrlProber(this);
 
   // Class to hold audio CD metadata about the current disk
   cdmetadata = new MetaData(static_cast<QObject*>(this) );
@@ -233,6 +236,8 @@ Playlist::Playlist(QWidget* parent)
   connect (ui.listWidget_playlist, SIGNAL(currentItemChanged(QListWidgetItem*, QListWidgetItem*)), this, SLOT(currentItemChanged(QListWidgetItem*, QListWidgetItem*)));
   connect (ui.checkBox_wrap, SIGNAL(toggled(bool)), this, SIGNAL(wrapModeChanged(bool)));
   connect (ui.checkBox_random, SIGNAL(toggled(bool)), this, SIGNAL(randomModeChanged(bool)));
+  connect (urlprober, SIGNAL(probed(QString, GstDiscovererInfo*, QString)), this, SLOT(urlProbed(QString, GstDiscovererInfo*, QString)));
+  connect (urlprober, SIGNAL(unreachable(QString, QString)), this, SLOT(urlUnreachable(QString, QString)));
   
 	settings->deleteLater();
  
@@ -352,6 +357,26 @@ bool Playlist::selectItem(const short& direction)
 	return true;
 }
 
+//
+// Function to return the URI of the item Next will play if it is a URL,
+// otherwise an empty string.  Random play has no known next item.
+QString Playlist::getNextUrl()
+{
+	const int count = ui.listWidget_playlist->count();
+	if (count < 2 || ui.checkBox_random->isChecked() ) return QString();
+	
+	int row = ui.listWidget_playlist->currentRow() + 1;
+	if (row > count - 1) {
+		if (! ui.checkBox_wrap->isChecked() ) return QString();
+		row = 0;
+	}
+	
+	QListWidgetItem* item = ui.listWidget_playlist->item(row);
+	if (! item || item->type() != MBMP_PL::Url) return QString();
+	
+	return static_cast<PlaylistItem*>(item)->getUri();
+}
+
 //
 //	Slot to present a choice of media types to open
 void Playlist::addMedia()
@@ -442,6 +467,7 @@ void Playlist::addURL()
 			if (ui.listWidget_playlist->item(0)->type() && (MBMP_PL::ACD | MBMP_PL::DVD)) ui.listWidget_playlist->clear();
 		}	// if
 		new PlaylistItem(s, ui.listWidget_playlist, MBMP_PL::Url);	
+		this->probeUrl(s);
 	}	// if
 
 	// update the summary count
@@ -464,6 +490,7 @@ void Playlist::addURI(const QString& uri)
 		
 	else if (url.scheme().contains("http", Qt::CaseSensitive) ) {
 		new PlaylistItem(url.toString(), ui.listWidget_playlist, MBMP_PL::Url);	
+		this->probeUrl(url.toString() );
 		this->updateSummary();	
 	}
 	
@@ -748,6 +775,15 @@ void Playlist::currentItemChanged(QListWidgetItem* cur, QListWidgetItem* old)
 		}	// else didn't find one in the music directory	
 	}	// if playing local file
 	
+	// URL items have whatever the prober found, if it has run yet
+	else if (this->currentItemType() == MBMP_PL::Url) {
+		QString s = static_cast<PlaylistItem*>(cur)->getInfoText();
+		if (! s.isEmpty() ) ui.label_iteminfo->setText(s);
+		
+		if (static_cast<PlaylistItem*>(cur)->hasArtwork())
+			ui.label_artwork->setPixmap(static_cast<PlaylistItem*>(cur)->getArtwork() ); 	
+	}
+	
 	else if (this->currentItemType() == MBMP_PL::ACD) {
 		QString s = static_cast<PlaylistItem*>(cur)->getInfoText();
 		if (! s.isEmpty() ) ui.label_iteminfo->setText(s);
@@ -768,6 +804,7 @@ void Playlist::seedPlaylist(const QStringList& sl_seed)
 	for (int i = 0; i < sl_seed.size(); ++i) {
 		if (sl_seed.at(i).startsWith("ftp", Qt::CaseInsensitive) || sl_seed.at(i).startsWith("http", Qt::CaseInsensitive)) {
 			new PlaylistItem(sl_seed.at(i), ui.listWidget_playlist, MBMP_PL::Url);
+			this->probeUrl(sl_seed.at(i) );
 		}	// if
 		
 		else {
@@ -919,6 +956,7 @@ void Playlist::processM3U(const QString& plfile)
 			line = in.readLine();
 			if (line.startsWith("ftp") || line.startsWith("http") ) {
 				new PlaylistItem(line, ui.listWidget_playlist, MBMP_PL::Url);
+				this->probeUrl(line);
 			}	// if a URL
 			else {
 				QFileInfo itemtarget = QFileInfo(line);
@@ -966,6 +1004,7 @@ void Playlist::processPLS(const QString& plfile)
 		for (int i = 0; i < sl.count(); ++i) {
 			if (sl.at(i).startsWith("ftp") || sl.at(i).startsWith("http") ) {
 				new PlaylistItem(sl.at(i), ui.listWidget_playlist, MBMP_PL::Url);
+				this->probeUrl(sl.at(i) );
 			}	// if a URL
 			else if (! sl.at(i).isEmpty() ) {
 				QFileInfo itemtarget = QFileInfo(sl.at(i));
@@ -1002,7 +1041,7 @@ void Playlist::updateSummary()
 	// Walk through the playlist and get the duration for each item
   for (int i = 0; i < ui.listWidget_playlist->count(); ++i) {
 		PlaylistItem* pli = static_cast<PlaylistItem*>(ui.listWidget_playlist->item(i));
-		totaltime = totaltime + pli->getDuration();
+		if (pli->getDuration() > 0) totaltime = totaltime + pli->getDuration();
 	}
 	
 	if (totaltime == 0) 
@@ -1211,3 +1250,53 @@ QPixmap Playlist::getLocalAlbumArt(const QStringList& searchtags, const QDir& di
 	return QPixmap();
 }
 
+//
+// Function to send a URL to the prober, unless the user has told us to
+// stay off the internet
+void Playlist::probeUrl(const QString& url)
+{
+	QSettings* settings = new QSettings(ORG, APP, this);
+	settings->beginGroup("Preferences");
+	bool b_disable_internet = settings->value("disable_internet").toBool();
+	settings->endGroup();
+	settings->deleteLater();
+	
+	if (! b_disable_internet) urlprober->probe(url);
+	
+	return;
+}
+
+////////////////////////////// Private Slots ////////////////////////////
+//
+// Slot to fill in the URL items the prober has finished with.  The same
+// URL may be in the playlist more than once.  info is only good until we
+// return.
+void Playlist::urlProbed(const QString& url, GstDiscovererInfo* info, const QString& message)
+{
+	for (int i = 0; i < ui.listWidget_playlist->count(); ++i) {
+		PlaylistItem* pli = static_cast<PlaylistItem*>(ui.listWidget_playlist->item(i));
+		if (pli->type() == MBMP_PL::Url && pli->getUri() == url) {
+			pli->setProbeResult(info, message);
+			if (pli == ui.listWidget_playlist->currentItem() ) this->currentItemChanged(pli, pli);
+		}	// if
+	}	// for
+	
+	this->updateSummary();
+	return;
+}
+
+//
+// Slot to mark URL items the prober could not reach
+void Playlist::urlUnreachable(const QString& url, const QString& reason)
+{
+	for (int i = 0; i < ui.listWidget_playlist->count(); ++i) {
+		PlaylistItem* pli = static_cast<PlaylistItem*>(ui.listWidget_playlist->item(i));
+		if (pli->type() == MBMP_PL::Url && pli->getUri() == url) {
+			pli->setUnreachable(reason);
+			if (pli == ui.listWidget_playlist->currentItem() ) this->currentItemChanged(pli, pli);
+		}	// if
+	}	// for
+	
+	return;
+}
+
@@ -45,6 +45,7 @@ DEALINGS IN THE SOFTWARE.
 # include "./code/playlist/playlistitem.h"
 # include "./code/gstiface/gstiface.h"
 # include "./code/mbman/mbman.h"
+# include "./code/urlprober/urlprober.h"
 
 //	Enum's local to this program
 namespace MBMP_PL 
@@ -120,6 +121,7 @@ class Playlist : public QWidget
   public slots:
 		void savePlaylist();
 		bool selectItem(const short&);
+		QString getNextUrl();
 		void addMedia();
 		void addFile(QAction*);	
 		void addURL();
@@ -160,6 +162,7 @@ class Playlist : public QWidget
 		
 		inline int currentItemType() {return ui.listWidget_playlist->count() > 0 ? ui.listWidget_playlist->currentItem()->type() : MBMP_PL::None;}
 		inline bool currentIsPlayable() {return ui.listWidget_playlist->count() > 0 ? static_cast<PlaylistItem*>(ui.listWidget_playlist->currentItem())->isPlayable() : false;}
+		inline bool currentIsAudioOnly() {return ui.listWidget_playlist->count() > 0 ? static_cast<PlaylistItem*>(ui.listWidget_playlist->currentItem())->isAudioOnly() : false;}
 		inline bool currentIsSeekable() {return ui.listWidget_playlist->count() > 0 ? static_cast<PlaylistItem*>(ui.listWidget_playlist->currentItem())->isSeekable() : false;}
 		void currentItemChanged(QListWidgetItem*, QListWidgetItem*);
 		
@@ -185,6 +188,7 @@ class Playlist : public QWidget
     QDir cdmeta_dir;
 	  MetaData* cdmetadata;
 	  MusicBrainzManager* mbman; 
+	  UrlProber* urlprober;
 	  QUrl arturl;
 	  bool cangonext;
 	  bool cangoprevious;
@@ -196,6 +200,11 @@ class Playlist : public QWidget
 		bool readCDMetaFile(const QString&);
 		void updateTracks();
 		QPixmap getLocalAlbumArt(const QStringList&, const QDir& = QDir("NONE"));
+		void probeUrl(const QString&);
+	
+	private slots:
+		void urlProbed(const QString&, GstDiscovererInfo*, const QString&);
+		void urlUnreachable(const QString&, const QString&);
 		
 	Q_SIGNALS:	
 		void wrapModeChanged(const bool&);	
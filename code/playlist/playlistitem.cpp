@@ -40,6 +40,8 @@ PlaylistItem::PlaylistItem(const QString& text, QListWidget* parent, int type) :
 	duration = -1;	
 	uri = QString();	
 	seekable = false;		
+	n_audio = -1;
+	n_video = -1;
 	title.clear();
 	artist.clear();
 	album.clear();
@@ -49,6 +51,7 @@ PlaylistItem::PlaylistItem(const QString& text, QListWidget* parent, int type) :
 	b_has_lyrics = false;
 	b_has_artwork = false;
 	pm_artwork = QPixmap();
+	b_probed = false;
 	
 	// Somewhat of a hack, but to display text in nice columns we either need a full QTableWidget (or worse a QTableView),
 	// or QListWidgetItems with monospace text.  Since we're only looking for appearance, not function, monospace fonts
@@ -98,15 +101,47 @@ QString PlaylistItem::getTagAsString(const QString& tag)
 		return QString();
 }
 
+//
+// Function to fill in a URL item from a discoverer pass made by the
+// UrlProber.  Only the first result is used, the display text is built
+// on the original text.
+void PlaylistItem::setProbeResult(GstDiscovererInfo* info, const QString& message)
+{
+	if (b_probed) return;
+	b_probed = true;
+	
+	this->processDiscovererInfo(info, message);
+	this->makeDisplayText();
+	
+	return;
+}
+
+//
+// Function to mark a URL item the UrlProber could not reach
+void PlaylistItem::setUnreachable(const QString& reason)
+{
+	if (b_probed) return;
+	b_probed = true;
+	
+	errors.append(QObject::tr("Unreachable: %1").arg(reason) );
+	errors.append("\n");
+	errors.append(QObject::tr("This URI may not be able to be played") );
+	this->setForeground(Qt::red);
+	this->makeDisplayText();
+	
+	return;
+}
+
 //
 // Function to set the display text for the PlaylistItem
 // called from the constructor and from playlist.cpp when we are
-// making ACD or DVD items
+// making ACD or DVD items, and after a URL item has been probed
 void PlaylistItem::makeDisplayText()
 {
 	// process based on the item type
 	switch (this->type()) {
-		case MBMP_PL::File: {
+		case MBMP_PL::File:
+		case MBMP_PL::Url: {
 			// Constants
 			const short wcol1 = -10;
 			const short wcol2 = -25;	
@@ -143,10 +178,7 @@ void PlaylistItem::makeDisplayText()
 					}	// else artist or album are not empty
 				}	// else title is not empty
 			}	// else	there is a duration
-			break; }	// case PlaylistItem is a file
-		
-		case MBMP_PL::Url: {
-			break; }	// case PlaylistItem is a url
+			break; }	// case PlaylistItem is a file or url
 		
 		case MBMP_PL::ACD: {
 			// Constants
@@ -236,7 +268,6 @@ void PlaylistItem::runDiscoverer()
 	// Variables (actually pointers)
 	GstDiscoverer* disc = NULL;
 	GstDiscovererInfo* info = NULL;
-	const GstTagList* tags = NULL;
 	GError* err = NULL;
 	
 	// Create the discoverer
@@ -253,6 +284,31 @@ void PlaylistItem::runDiscoverer()
 	
 	// Run discoverer on the url
 	info = gst_discoverer_discover_uri(disc, qPrintable(uri), &err);
+	this->processDiscovererInfo(info, err ? QString(err->message) : QString() );
+	g_clear_error (&err);
+	
+	// clean up discoverer stuff
+	if (info) gst_discoverer_info_unref(info);
+	g_object_unref (disc);	
+	
+	return;
+}
+
+//
+// Function to pull what we want out of a discoverer result.  message is the
+// GError text, if any.  Called from runDiscoverer() for files and from
+// setProbeResult() for URLs.  info belongs to the caller.
+void PlaylistItem::processDiscovererInfo(GstDiscovererInfo* info, const QString& message)
+{
+	const GstTagList* tags = NULL;
+	
+	if (! info) {
+		errors.append(QObject::tr("Discoverer Result: <br>Error: %1").arg(message) );
+		errors.append("\n");
+		errors.append(QObject::tr("This URI may not be able to be played") );
+		this->setForeground(Qt::red);
+		return;
+	}
 	
 	// Process the dicoverer result
 	GstDiscovererResult result;
@@ -264,9 +320,8 @@ void PlaylistItem::runDiscoverer()
 			s0.append("\n");
 			break;
 		case GST_DISCOVERER_ERROR:
-			s0.append(QObject::tr("<br>Error: %1").arg(err->message) );
+			s0.append(QObject::tr("<br>Error: %1").arg(message) );
 			s0.append("\n");
-			g_clear_error (&err);				
 			break;
 		case GST_DISCOVERER_TIMEOUT:
 			s0.append(QObject::tr("<br>Timeout"));
@@ -292,16 +347,27 @@ void PlaylistItem::runDiscoverer()
 	if (result != GST_DISCOVERER_OK) {
 		errors.append(s0);
 		errors.append(QObject::tr("This URI may not be able to be played") );
-		gst_discoverer_info_unref(info);
-		g_object_unref (disc);
 		this->setForeground(Qt::red);
 		return;
 	}
 	
-	// Get information not in tags
-	duration = gst_discoverer_info_get_duration(info) / (1000 * 1000 * 1000);
+	// Get information not in tags.  Live streams have no duration.
+	if (GST_CLOCK_TIME_IS_VALID(gst_discoverer_info_get_duration(info)) )
+		duration = gst_discoverer_info_get_duration(info) / (1000 * 1000 * 1000);
 	seekable = static_cast<bool>(gst_discoverer_info_get_seekable(info) ); 		
 	
+	// Count the streams.  Cover art shows up as a single image video stream,
+	// don't count that as video.
+	GList* streams = gst_discoverer_info_get_audio_streams(info);
+	n_audio = g_list_length(streams);
+	gst_discoverer_stream_info_list_free(streams);
+	n_video = 0;
+	streams = gst_discoverer_info_get_video_streams(info);
+	for (GList* l = streams; l != NULL; l = l->next) {
+		if (! gst_discoverer_video_info_is_image(GST_DISCOVERER_VIDEO_INFO(l->data)) ) ++n_video;
+	}
+	gst_discoverer_stream_info_list_free(streams);
+	
 	// Get tags and try to extract information from them
 	tags = gst_discoverer_info_get_tags(info);	// tags belongs to info
 	
@@ -367,10 +433,6 @@ void PlaylistItem::runDiscoverer()
 		}	// if saving pixmap worked
 		
 	}	// if there were tags
-
-	// clean up discoverer stuff
-	gst_discoverer_info_unref(info);
-	g_object_unref (disc);	
 	
 	return;
 }
@@ -49,6 +49,7 @@ class PlaylistItem : public QListWidgetItem
 		inline qint16 getSequence() {return sequence;}
 		inline QString getUri() {return uri;}
 		inline bool isSeekable() {return seekable;}
+		inline bool isAudioOnly() {return n_audio > 0 && n_video == 0;}
 		inline QString getArtist() {return artist;}
 		inline QString getTitle() {return title;}
 		inline qint32 getDuration() {return duration;}
@@ -70,6 +71,8 @@ class PlaylistItem : public QListWidgetItem
 		
 		// functions
 		void makeDisplayText();
+		void setProbeResult(GstDiscovererInfo*, const QString&);
+		void setUnreachable(const QString&);
 		
 	private:
 	// members - which ones are used depends upon the item type
@@ -77,6 +80,8 @@ class PlaylistItem : public QListWidgetItem
 		qint32 duration;			// length in seconds, or a negative number for duation not known		
 		QString uri;					// the uri of the media 
 		bool seekable;				// true if we can seek in the stream, false otherwise	
+		qint8 n_audio;				// audio streams found by the discoverer, -1 if not known
+		qint8 n_video;				// video streams (not cover art images), -1 if not known
 		QString title;				// the title tag of the media file
 		QString artist;				// the artist tag
 		QString album;				// the album tag
@@ -86,10 +91,12 @@ class PlaylistItem : public QListWidgetItem
 		bool b_has_artwork;		// true if the tags contain artwork 
 		QPixmap pm_artwork;		// the artwork extracted from GStreamer tags
 		QMap<QString,QString> tag_map;	// tags and values stored in a QMap
+		bool b_probed;				// true once a URL item has been through the prober
 		
 	// functions	
 		void makeToolTip();
 		void runDiscoverer();
+		void processDiscovererInfo(GstDiscovererInfo*, const QString&);
 		
 };
 		
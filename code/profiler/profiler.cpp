@@ -0,0 +1,376 @@
+/**************************** profiler.cpp *****************************
+
+Class to collect GStreamer tracer records from the running playbin and
+summarize them per element
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include <QProcessEnvironment>
+# include <QStringList>
+# include <QDateTime>
+# include <QFile>
+# include <QDir>
+# include <QPair>
+
+# include <algorithm>
+
+# include "./code/profiler/profiler.h"
+# include "./code/resource.h"
+
+// Constants
+static const int report_interval = 1000;		// update the report this often (ms)
+static const int max_report_elements = 8;		// most elements listed in the report
+
+// Callback Function: GStreamer log function.  Pass the records the tracers
+// log in the GST_TRACER category to the profiler in data, ignore all other
+// log messages.  Called from any thread.
+static void tracerLog(GstDebugCategory* category, GstDebugLevel level, const gchar* file, const gchar* function, gint line, GObject* object, GstDebugMessage* message, gpointer data)
+{
+	(void) file;
+	(void) function;
+	(void) line;
+	(void) object;
+
+	if (level != GST_LEVEL_TRACE || qstrcmp(gst_debug_category_get_name(category), "GST_TRACER") != 0) return;
+
+	gchar* end = NULL;
+	GstStructure* s = gst_structure_from_string(gst_debug_message_get(message), &end);
+	if (! s) return;
+	((PipelineProfiler*) data)->addRecord(s);
+	gst_structure_free(s);
+
+	return;
+}
+
+// Helper Function: Add a time to a ProfileTiming
+static void addTiming(ProfileTiming& timing, guint64 t)
+{
+	++timing.count;
+	timing.sum += t;
+	if (t > timing.max) timing.max = t;
+
+	return;
+}
+
+// Helper Function: Return the average of a ProfileTiming in milliseconds
+static double averageMs(const ProfileTiming& timing)
+{
+	return timing.count > 0 ? static_cast<double>(timing.sum) / timing.count / 1000000.0 : 0.0;
+}
+
+// Constructor
+PipelineProfiler::PipelineProfiler(QObject* parent) : QObject(parent)
+{
+	// data members
+	active = false;
+	removed_default = false;
+	tracers.clear();
+	this->clear();
+
+	timer = new QTimer(this);
+	timer->setInterval(report_interval);
+	connect(timer, SIGNAL(timeout()), this, SLOT(emitReport()));
+}
+
+// Destructor.  The tracers stay, GStreamer keeps using them until exit.
+PipelineProfiler::~PipelineProfiler()
+{
+	stop();
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to start profiling.  The tracers are created the first time,
+// they hook into every pipeline in the process so they only ever get
+// created when asked for.  GStreamer has no way to remove a tracer so
+// stop() only stops reading the records.
+void PipelineProfiler::start()
+{
+	if (active) return;
+	this->clear();
+	createTracers();
+
+	// read the records with our own log function.  Unless the user asked for
+	// a GStreamer debug log keep them off stderr while we profile.
+	removed_default = qgetenv("GST_DEBUG").isEmpty();
+	if (removed_default) gst_debug_remove_log_function(gst_debug_log_default);
+	gst_debug_add_log_function(tracerLog, this, NULL);
+	gst_debug_set_active(TRUE);
+	gst_debug_set_threshold_for_name("GST_TRACER", GST_LEVEL_TRACE);
+
+	active = true;
+	timer->start();
+
+	return;
+}
+
+//
+// Function to stop profiling.  The numbers collected are kept until the
+// next start() so they can still be read and dumped.
+void PipelineProfiler::stop()
+{
+	if (! active) return;
+
+	timer->stop();
+	gst_debug_unset_threshold_for_name("GST_TRACER");
+	gst_debug_remove_log_function(tracerLog);
+	if (removed_default) gst_debug_add_log_function(gst_debug_log_default, NULL, NULL);
+	removed_default = false;
+	active = false;
+
+	return;
+}
+
+//
+// Function to forget the numbers collected.  Called when a new stream starts.
+void PipelineProfiler::clear()
+{
+	QMutexLocker locker(&mutex);
+
+	pipeline_latency.clear();
+	element_latency.clear();
+	thread_load.clear();
+	proc_load = 0;
+	queue_bytes.clear();
+	queue_time.clear();
+	element_names.clear();
+	element_buffers.clear();
+
+	return;
+}
+
+//
+// Function to add one tracer record to the numbers.  Called from
+// tracerLog() in whatever thread logged the record.
+//	latency, element-latency - latency tracer (ns)
+//	thread-rusage, proc-rusage - rusage tracer (cpu load in per mille)
+//	new-element, buffer - stats tracer
+//	queue-levels - queue-levels tracer (gst-plugins-rs)
+void PipelineProfiler::addRecord(const GstStructure* s)
+{
+	QMutexLocker locker(&mutex);
+	const QString name = QString(gst_structure_get_name(s));
+	guint64 t = 0;
+	guint ix = 0;
+	guint u = 0;
+
+	if (name == "latency") {
+		if (gst_structure_get_uint64(s, "time", &t) )
+			addTiming(pipeline_latency[QString("%1 -> %2").arg(gst_structure_get_string(s, "src-element")).arg(gst_structure_get_string(s, "sink-element"))], t);
+	}
+
+	else if (name == "element-latency") {
+		if (gst_structure_get_uint64(s, "time", &t) )
+			addTiming(element_latency[QString(gst_structure_get_string(s, "element"))], t);
+	}
+
+	else if (name == "thread-rusage") {
+		if (gst_structure_get_uint64(s, "thread-id", &t) && gst_structure_get_uint(s, "average-cpuload", &u) )
+			thread_load[t] = u;
+	}
+
+	else if (name == "proc-rusage") {
+		if (gst_structure_get_uint(s, "average-cpuload", &u) ) proc_load = u;
+	}
+
+	else if (name == "new-element") {
+		if (gst_structure_get_uint(s, "ix", &ix) ) element_names[ix] = QString(gst_structure_get_string(s, "name"));
+	}
+
+	else if (name == "buffer") {
+		if (gst_structure_get_uint(s, "element-ix", &ix) ) {
+			gst_structure_get_uint(s, "buffer-size", &u);
+			addTiming(element_buffers[ix], u);
+		}
+	}
+
+	else if (name == "queue-levels") {
+		const QString queue = QString(gst_structure_get_string(s, "queue-name"));
+		if (gst_structure_get_uint(s, "cur-level-bytes", &u) ) queue_bytes[queue] = qMax(queue_bytes.value(queue), static_cast<guint64>(u) );
+		if (gst_structure_get_uint64(s, "cur-level-time", &t) ) queue_time[queue] = qMax(queue_time.value(queue), t);
+	}
+
+	return;
+}
+
+//
+// Function to return a text report of the numbers collected so far
+QString PipelineProfiler::report()
+{
+	QMutexLocker locker(&mutex);
+	QStringList sl;
+
+	if (! pipeline_latency.isEmpty() ) {
+		sl << tr("Pipeline latency (average / maximum):");
+		QMap<QString, ProfileTiming>::const_iterator i;
+		for (i = pipeline_latency.constBegin(); i != pipeline_latency.constEnd(); ++i) {
+			sl << QString("  %1: %2 / %3 ms").arg(i.key()).arg(averageMs(i.value()), 0, 'f', 2).arg(i.value().max / 1000000.0, 0, 'f', 2);
+		}
+	}	// if pipeline latency
+
+	// elements, the most time consuming first
+	QList<QPair<double, QString> > list;
+	QMap<QString, ProfileTiming>::const_iterator i;
+	for (i = element_latency.constBegin(); i != element_latency.constEnd(); ++i) {
+		list << qMakePair(averageMs(i.value()), i.key());
+	}
+	if (list.isEmpty() ) {
+		QMap<guint, ProfileTiming>::const_iterator j;
+		for (j = element_buffers.constBegin(); j != element_buffers.constEnd(); ++j) {
+			list << qMakePair(static_cast<double>(j.value().sum), element_names.value(j.key(), QString::number(j.key())) );
+		}
+	}
+	std::sort(list.begin(), list.end());
+	if (! list.isEmpty() ) {
+		sl << tr("Elements, most costly first:");
+		for (int n = 0; n < list.count() && n < max_report_elements; ++n) {
+			sl << QString("  %1").arg(elementSummary(list.at(list.count() - 1 - n).second, ", "));
+		}
+	}	// if elements
+
+	if (proc_load > 0 || ! thread_load.isEmpty() ) {
+		guint busiest = 0;
+		QMap<guint64, guint>::const_iterator k;
+		for (k = thread_load.constBegin(); k != thread_load.constEnd(); ++k) {
+			busiest = qMax(busiest, k.value());
+		}
+		sl << QString(tr("CPU load: process %1%, busiest of %2 threads %3%")).arg(proc_load / 10.0, 0, 'f', 1).arg(thread_load.count()).arg(busiest / 10.0, 0, 'f', 1);
+	}	// if cpu load
+
+	if (! queue_bytes.isEmpty() || ! queue_time.isEmpty() ) {
+		sl << tr("Queue levels (maximum):");
+		QStringList queues = queue_bytes.keys() + queue_time.keys();
+		queues.removeDuplicates();
+		for (int n = 0; n < queues.count(); ++n) {
+			sl << QString("  %1: %2 KB, %3 ms").arg(queues.at(n)).arg(queue_bytes.value(queues.at(n)) / 1024).arg(queue_time.value(queues.at(n)) / 1000000);
+		}
+	}	// if queues
+
+	if (sl.isEmpty() ) sl << tr("Waiting for tracer records");
+
+	return sl.join("\n");
+}
+
+//
+// Function to write a DOT graph of pipeline annotated with the element
+// numbers to the cache directory.  Return the file name, or an empty string
+// if the graph could not be written.
+QString PipelineProfiler::dumpGraph(GstElement* pipeline)
+{
+	gchar* data = gst_debug_bin_to_dot_data(GST_BIN(pipeline), GST_DEBUG_GRAPH_SHOW_ALL);
+	if (! data) return QString();
+	QString dot = QString::fromUtf8(data);
+	g_free(data);
+
+	// element labels in the graph read Type\nname\n..., add our numbers after the name
+	{
+		QMutexLocker locker(&mutex);
+		QStringList names = element_latency.keys() + element_names.values();
+		names.removeDuplicates();
+		for (int i = 0; i < names.count(); ++i) {
+			const QString summary = elementSummary(names.at(i), "\\n");
+			if (! names.at(i).isEmpty() ) dot.replace(QString("\\n%1\\n").arg(names.at(i)), QString("\\n%1\\n").arg(summary) );
+		}
+	}
+
+	QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+	QDir dir(QString(env.value("XDG_CACHE_HOME", QString(QDir::homePath()) + "/.cache") + "/%1/profiles").arg(QString(APP).toLower()) );
+	if (! dir.exists() ) dir.mkpath(dir.absolutePath() );
+	QFile file(dir.absoluteFilePath(QString("%1.dot").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))) );
+	if (! file.open(QIODevice::WriteOnly | QIODevice::Text) ) return QString();
+	file.write(dot.toUtf8() );
+	file.close();
+
+	return file.fileName();
+}
+
+///////////////////////////// Private Functions /////////////////////////
+//
+// Function to create the tracers we read.  Tracers that are not installed
+// are skipped, the latency tracer is asked for element latency as well if
+// it takes parameters (GStreamer 1.18 and later).
+void PipelineProfiler::createTracers()
+{
+	if (! tracers.isEmpty() ) return;
+
+	const char* names[] = {"latency", "rusage", "stats", "queue-levels"};
+	for (uint i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		GstPluginFeature* feature = gst_registry_find_feature(gst_registry_get(), names[i], GST_TYPE_TRACER_FACTORY);
+		if (! feature) continue;
+		GstPluginFeature* loaded = gst_plugin_feature_load(feature);
+		gst_object_unref(feature);
+		if (! loaded) continue;
+
+		GType type = gst_tracer_factory_get_tracer_type(GST_TRACER_FACTORY(loaded));
+		gst_object_unref(loaded);
+		if (type == G_TYPE_NONE) continue;
+
+		GObjectClass* klass = G_OBJECT_CLASS(g_type_class_ref(type));
+		GstTracer* tracer = NULL;
+		if (qstrcmp(names[i], "latency") == 0 && g_object_class_find_property(klass, "params") )
+			tracer = GST_TRACER(g_object_new(type, "params", "flags=pipeline+element", NULL));
+		else
+			tracer = GST_TRACER(g_object_new(type, NULL));
+		g_type_class_unref(klass);
+
+		if (tracer) {
+			gst_object_ref_sink(tracer);
+			tracers << tracer;
+		}
+	}	// for
+
+	return;
+}
+
+//
+// Function to return the numbers for one element, fields separated by sep.
+// Caller must hold the mutex.
+QString PipelineProfiler::elementSummary(const QString& name, const QString& sep)
+{
+	QStringList sl;
+	sl << name;
+
+	if (element_latency.contains(name) ) {
+		const ProfileTiming& t = element_latency[name];
+		sl << QString(tr("time %1 / %2 ms")).arg(averageMs(t), 0, 'f', 2).arg(t.max / 1000000.0, 0, 'f', 2);
+	}
+
+	const guint ix = element_names.key(name, G_MAXUINT);
+	if (ix != G_MAXUINT && element_buffers.contains(ix) ) {
+		const ProfileTiming& b = element_buffers[ix];
+		sl << QString(tr("%1 buffers, %2 KB")).arg(b.count).arg(b.sum / 1024);
+	}
+
+	return sl.join(sep);
+}
+
+//////////////////////////// Private Slots //////////////////////////
+//
+// Slot to send the report, called from timer while profiling
+void PipelineProfiler::emitReport()
+{
+	emit reportReady(report() );
+
+	return;
+}
@@ -0,0 +1,96 @@
+/**************************** profiler.h *******************************
+
+Class to collect GStreamer tracer records from the running playbin and
+summarize them per element
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef PROFILER_H
+# define PROFILER_H
+
+# include <gst/gst.h>
+
+# include <QObject>
+# include <QString>
+# include <QTimer>
+# include <QMutex>
+# include <QMap>
+# include <QList>
+
+//	Structure to accumulate a series of times (ns)
+struct ProfileTiming
+{
+	guint64 count;		// number of samples
+	guint64 sum;			// sum of the samples
+	guint64 max;			// largest sample
+};
+
+//	Class to run GStreamer tracers (latency, rusage, stats and queue-levels
+//	when installed) and aggregate the records they log in process.  The
+//	records are read from the GST_TRACER debug category through our own log
+//	function, nothing goes to a log file.
+class PipelineProfiler : public QObject
+{
+	Q_OBJECT
+
+	public:
+		PipelineProfiler(QObject*);
+		~PipelineProfiler();
+
+		void start();
+		void stop();
+		void clear();
+		void addRecord(const GstStructure*);
+		QString report();
+		QString dumpGraph(GstElement*);
+		inline bool isActive() {return active;}
+
+	signals:
+		void reportReady(const QString&);
+
+	private:
+		// members
+		bool active;
+		bool removed_default;
+		QTimer* timer;
+		QMutex mutex;
+		QList<GstTracer*> tracers;
+		QMap<QString, ProfileTiming> pipeline_latency;
+		QMap<QString, ProfileTiming> element_latency;
+		QMap<guint64, guint> thread_load;
+		guint proc_load;
+		QMap<QString, guint64> queue_bytes;
+		QMap<QString, guint64> queue_time;
+		QMap<guint, QString> element_names;
+		QMap<guint, ProfileTiming> element_buffers;
+
+		// functions
+		void createTracers();
+		QString elementSummary(const QString&, const QString&);
+
+	private slots:
+		void emitReport();
+};
+
+# endif
@@ -0,0 +1,417 @@
+/**************************** recorder.cpp *****************************
+
+Class to record the stream being played to a file by copying the
+demuxed data out of the running pipeline
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include "./code/recorder/recorder.h"
+
+# include <gst/app/gstappsrc.h>
+
+# include <QStandardPaths>
+# include <QDateTime>
+# include <QDir>
+# include <QTimer>
+
+// Constants
+static const int finish_timeout = 3;		// seconds we wait for the muxer to write its index
+
+// A decoder input found in the playing pipeline
+struct DecoderInput
+{
+	GstPad* pad;
+	bool video;
+};
+
+// Callback Function: Collect the sink pads of the audio and video decoders
+// in the playing pipeline, what goes in there is demuxed and parsed
+static void findDecoderInputs(const GValue* value, gpointer data)
+{
+	GstElement* element = GST_ELEMENT(g_value_get_object(value));
+	QList<DecoderInput>* inputs = static_cast<QList<DecoderInput>*>(data);
+	
+	GstElementFactory* factory = gst_element_get_factory(element);
+	if (! factory) return;
+	const QString klass = QString(gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) );
+	if (! klass.contains("Decoder") ) return;
+	if (! klass.contains("Audio") && ! klass.contains("Video") ) return;
+	
+	GstPad* pad = gst_element_get_static_pad(element, "sink");
+	if (! pad) return;
+	
+	DecoderInput input;
+	input.pad = pad;
+	input.video = klass.contains("Video");
+	inputs->append(input);
+	
+	return;
+}
+
+// Callback Function: Copy a buffer going into a decoder into the recording.
+// The copy shares the memory, only the timestamps are changed so the file
+// starts at 0.  Buffers from before the start (a seek back while recording)
+// are left out.  Runs in the streaming thread of the pad.
+static GstPadProbeReturn recordProbe(GstPad* pad, GstPadProbeInfo* info, gpointer data)
+{
+	(void) pad;
+	RecordTap* tap = static_cast<RecordTap*>(data);
+	
+	// follow caps changes
+	if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+		GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+		if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+			GstCaps* caps = NULL;
+			gst_event_parse_caps(event, &caps);
+			g_object_set(G_OBJECT(tap->appsrc), "caps", caps, NULL);
+		}
+		return GST_PAD_PROBE_OK;
+	}	// if event
+	
+	GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+	if (! buffer) return GST_PAD_PROBE_OK;
+	if (! tap->started && tap->video && GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT) ) return GST_PAD_PROBE_OK;
+	const GstClockTime ts = GST_BUFFER_DTS_OR_PTS(buffer);
+	if (! GST_CLOCK_TIME_IS_VALID(ts) ) return GST_PAD_PROBE_OK;
+	
+	GstClockTime base;
+	tap->session->mutex.lock();
+	if (! GST_CLOCK_TIME_IS_VALID(tap->session->base) ) tap->session->base = ts;
+	base = tap->session->base;
+	tap->session->mutex.unlock();
+	
+	if (ts < base || (GST_CLOCK_TIME_IS_VALID(tap->last) && ts < tap->last) ) return GST_PAD_PROBE_OK;
+	tap->started = true;
+	tap->last = ts;
+	
+	GstBuffer* copy = gst_buffer_copy(buffer);
+	if (GST_BUFFER_PTS_IS_VALID(copy) ) GST_BUFFER_PTS(copy) = GST_BUFFER_PTS(copy) > base ? GST_BUFFER_PTS(copy) - base : 0;
+	if (GST_BUFFER_DTS_IS_VALID(copy) ) GST_BUFFER_DTS(copy) = GST_BUFFER_DTS(copy) > base ? GST_BUFFER_DTS(copy) - base : 0;
+	gst_app_src_push_buffer(GST_APP_SRC(tap->appsrc), copy);	// takes the copy
+	
+	return GST_PAD_PROBE_OK;
+}
+
+// Callback Function: Free a tap once its probe is removed and no streaming
+// thread is in it any more
+static void releaseTap(gpointer data)
+{
+	RecordTap* tap = static_cast<RecordTap*>(data);
+	gst_object_unref(tap->appsrc);
+	tap->session->unref();
+	delete tap;
+	
+	return;
+}
+
+// Callback Function: Watch the bus of a stopped recording for the muxer
+// to finish the file.  Runs in the main thread.
+static gboolean finishWatch(GstBus* bus, GstMessage* msg, gpointer data)
+{
+	(void) bus;
+	RecordFinish* f = static_cast<RecordFinish*>(data);
+	
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS) {
+		f->watch = 0;
+		f->recorder->finish(f, true, QString());
+		return FALSE;
+	}
+	
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+		GError* err = NULL;
+		gst_message_parse_error(msg, &err, NULL);
+		const QString s = QString::fromUtf8(err->message);
+		g_clear_error(&err);
+		f->watch = 0;
+		f->recorder->finish(f, false, s);
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+// Function to drop a reference to the session, the last one deletes it
+void RecordSession::unref()
+{
+	if (! refs.deref() ) delete this;
+	
+	return;
+}
+
+// Constructor
+StreamRecorder::StreamRecorder(QObject* parent) : QObject(parent)
+{
+	pipeline = NULL;
+	mux = NULL;
+	session = NULL;
+	filename.clear();
+	error.clear();
+}
+
+// Destructor.  The event loop is gone by now so wait for the files here,
+// up to finish_timeout seconds each.
+StreamRecorder::~StreamRecorder()
+{
+	blockSignals(true);
+	stop();
+	
+	while (! finishing.isEmpty() ) {
+		RecordFinish* f = finishing.first();
+		const qint64 left = qMax(Q_INT64_C(0), finish_timeout * 1000 - f->clock.elapsed() );
+		bool ok = true;
+		QString s;
+		GstBus* bus = gst_element_get_bus(f->pipeline);
+		GstMessage* msg = gst_bus_timed_pop_filtered(bus, left * GST_MSECOND, (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR) );
+		if (msg) {
+			if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+				GError* err = NULL;
+				gst_message_parse_error(msg, &err, NULL);
+				s = QString::fromUtf8(err->message);
+				g_clear_error(&err);
+				ok = false;
+			}
+			gst_message_unref(msg);
+		}	// if msg
+		gst_object_unref(bus);
+		finish(f, ok, s);
+	}	// while
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to start recording what playbin is playing to a file in dir
+// (the music or videos directory if empty) named after name.  Return false
+// and set the error string if nothing could be recorded.
+bool StreamRecorder::start(GstElement* playbin, const QString& dir, const QString& name)
+{
+	if (pipeline) return true;
+	error.clear();
+	
+	// the streams we can copy
+	QList<DecoderInput> inputs;
+	GstIterator* iter = gst_bin_iterate_recurse(GST_BIN(playbin));
+	gst_iterator_foreach(iter, findDecoderInputs, &inputs);
+	gst_iterator_free(iter);
+	if (inputs.isEmpty() ) {
+		error = tr("there is no demuxed audio or video in this stream to record");
+		return false;
+	}
+	
+	bool has_video = false;
+	for (int i = 0; i < inputs.count(); ++i) {
+		if (inputs.at(i).video) has_video = true;
+	}
+	
+	// the file
+	QDir d(dir.isEmpty() ? QStandardPaths::writableLocation(has_video ? QStandardPaths::MoviesLocation : QStandardPaths::MusicLocation) : dir);
+	if (! d.exists() ) d.mkpath(d.absolutePath() );
+	filename = d.absoluteFilePath(QString("%1-%2.mkv").arg(name).arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")) );
+	
+	// the recording pipeline
+	pipeline = gst_pipeline_new("mbmp_recorder");
+	mux = gst_element_factory_make("matroskamux", NULL);
+	GstElement* sink = gst_element_factory_make("filesink", NULL);
+	if (! mux || ! sink) {
+		error = tr("matroskamux or filesink is not installed");
+		if (mux) gst_object_unref(GST_OBJECT(mux));
+		if (sink) gst_object_unref(GST_OBJECT(sink));
+		gst_object_unref(GST_OBJECT(pipeline));
+		pipeline = NULL;
+		mux = NULL;
+		for (int i = 0; i < inputs.count(); ++i) gst_object_unref(inputs.at(i).pad);
+		return false;
+	}
+	g_object_set(G_OBJECT(sink), "location", qPrintable(filename), NULL);
+	gst_bin_add_many(GST_BIN(pipeline), mux, sink, NULL);
+	gst_element_link(mux, sink);
+	session = new RecordSession();
+	
+	// one appsrc for each stream the muxer takes
+	QList<GstPad*> pads;
+	QList<bool> kinds;
+	for (int i = 0; i < inputs.count(); ++i) {
+		if (addStream(inputs.at(i).pad) ) {
+			pads.append(inputs.at(i).pad);
+			kinds.append(inputs.at(i).video);
+		}
+		else 
+			gst_object_unref(inputs.at(i).pad);
+	}	// for
+	
+	if (sources.isEmpty() ) {
+		error = tr("none of the streams can be put in a Matroska file");
+		teardown();
+		return false;
+	}
+	
+	if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+		error = tr("could not write to %1").arg(filename);
+		for (int i = 0; i < pads.count(); ++i) gst_object_unref(pads.at(i));
+		teardown();
+		return false;
+	}
+	
+	// start copying
+	for (int i = 0; i < pads.count(); ++i) {
+		RecordTap* tap = new RecordTap;
+		tap->appsrc = GST_ELEMENT(gst_object_ref(sources.at(i)) );
+		tap->session = session;
+		session->refs.ref();
+		tap->video = kinds.at(i);
+		tap->started = false;
+		tap->last = GST_CLOCK_TIME_NONE;
+		const gulong id = gst_pad_add_probe(pads.at(i), (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM), recordProbe, tap, releaseTap);
+		probes.append(qMakePair(pads.at(i), id) );
+	}	// for
+	
+	return true;
+}
+
+//
+// Function to stop recording.  The muxer needs EOS to write its index,
+// that happens in the background and the finished signal is emitted once
+// the file is complete or after finish_timeout seconds.  We can start the
+// next recording right away.
+void StreamRecorder::stop()
+{
+	if (! pipeline) return;
+	
+	// stop copying, nothing in the playing pipeline changes
+	for (int i = 0; i < probes.count(); ++i) {
+		gst_pad_remove_probe(probes.at(i).first, probes.at(i).second);
+		gst_object_unref(probes.at(i).first);
+	}
+	probes.clear();
+	
+	// finish the file
+	for (int i = 0; i < sources.count(); ++i) {
+		gst_app_src_end_of_stream(GST_APP_SRC(sources.at(i)) );
+	}
+	RecordFinish* f = new RecordFinish;
+	f->recorder = this;
+	f->pipeline = pipeline;
+	f->filename = filename;
+	GstBus* bus = gst_element_get_bus(pipeline);
+	f->watch = gst_bus_add_watch(bus, finishWatch, f);
+	gst_object_unref(bus);
+	f->clock.start();
+	finishing.append(f);
+	QTimer::singleShot(finish_timeout * 1000, this, SLOT(finishTimeout()));
+	
+	// the pipeline belongs to f now
+	pipeline = NULL;
+	teardown();
+	
+	return;
+}
+
+//
+// Function to release a stopped recording once its file is finished (or
+// we gave up waiting) and tell whoever is listening.  ok is false and err
+// the reason if the recording failed along the way.
+void StreamRecorder::finish(RecordFinish* f, bool ok, const QString& err)
+{
+	if (! finishing.contains(f) ) return;
+	finishing.removeAll(f);
+	
+	if (f->watch > 0) g_source_remove(f->watch);
+	gst_element_set_state(f->pipeline, GST_STATE_NULL);
+	gst_object_unref(GST_OBJECT(f->pipeline));
+	emit finished(f->filename, ok, err);
+	delete f;
+	
+	return;
+}
+
+//////////////////////////// Private Functions ////////////////////////////
+//
+// Function to add appsrc ! parser to the muxer for a decoder input pad.
+// The parser is the best ranked one for the caps, it converts the stream
+// format if the muxer wants another one (ADTS to raw AAC, byte-stream to
+// avc H.264).  Return false if the stream can't go in the file.
+bool StreamRecorder::addStream(GstPad* pad)
+{
+	GstCaps* caps = gst_pad_get_current_caps(pad);
+	if (! caps) return false;
+	
+	GstElement* src = gst_element_factory_make("appsrc", NULL);
+	g_object_set(G_OBJECT(src), "caps", caps, "format", GST_FORMAT_TIME, "is-live", FALSE, NULL);
+	gst_bin_add(GST_BIN(pipeline), src);
+	
+	GList* all = gst_element_factory_list_get_elements(GST_ELEMENT_FACTORY_TYPE_PARSER, GST_RANK_MARGINAL);
+	GList* usable = gst_element_factory_list_filter(all, caps, GST_PAD_SINK, FALSE);
+	usable = g_list_sort(usable, (GCompareFunc) gst_plugin_feature_rank_compare_func);
+	GstElement* parser = usable ? gst_element_factory_create(GST_ELEMENT_FACTORY(usable->data), NULL) : NULL;
+	gst_plugin_feature_list_free(usable);
+	gst_plugin_feature_list_free(all);
+	gst_caps_unref(caps);
+	
+	bool linked = false;
+	if (parser) {
+		gst_bin_add(GST_BIN(pipeline), parser);
+		linked = gst_element_link_many(src, parser, mux, NULL);
+		if (! linked) gst_bin_remove(GST_BIN(pipeline), parser);
+	}
+	if (! linked) linked = gst_element_link(src, mux);
+	
+	if (! linked) {
+		gst_bin_remove(GST_BIN(pipeline), src);
+		return false;
+	}
+	
+	sources.append(src);
+	return true;
+}
+
+//
+// Function to release the recording pipeline
+void StreamRecorder::teardown()
+{
+	if (pipeline) {
+		gst_element_set_state(pipeline, GST_STATE_NULL);
+		gst_object_unref(GST_OBJECT(pipeline));
+	}
+	pipeline = NULL;
+	mux = NULL;
+	sources.clear();
+	if (session) session->unref();
+	session = NULL;
+	
+	return;
+}
+
+//////////////////////////// Private Slots ////////////////////////////////
+//
+// Slot to release the stopped recordings that did not finish in time.  The
+// file is usable without the index, it just can't be seeked in as well.
+// Timers may fire a little early so allow for that.
+void StreamRecorder::finishTimeout()
+{
+	const QList<RecordFinish*> l = finishing;
+	for (int i = 0; i < l.count(); ++i) {
+		if (l.at(i)->clock.elapsed() >= finish_timeout * 1000 - 250) finish(l.at(i), true, QString());
+	}
+	
+	return;
+}
@@ -0,0 +1,121 @@
+/**************************** recorder.h *******************************
+
+Class to record the stream being played to a file by copying the
+demuxed data out of the running pipeline
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef RECORDER_H
+# define RECORDER_H
+
+# include <gst/gst.h>
+
+# include <QObject>
+# include <QString>
+# include <QList>
+# include <QPair>
+# include <QMutex>
+# include <QAtomicInt>
+# include <QElapsedTimer>
+
+//	State shared by all streams of one recording.  The streaming threads
+//	use it after the recorder may have moved on, so it is reference counted
+//	and the last user deletes it.
+struct RecordSession
+{
+	QMutex mutex;
+	GstClockTime base;		// first timestamp recorded, becomes 0 in the file
+	QAtomicInt refs;
+	
+	RecordSession() : base(GST_CLOCK_TIME_NONE), refs(1) {}
+	void unref();
+};
+
+//	One decoder input we copy buffers from.  Owned by its pad probe.
+struct RecordTap
+{
+	GstElement* appsrc;		// where the copies go, we hold a reference
+	RecordSession* session;
+	bool video;						// video has to start on a keyframe
+	bool started;					// true once the first buffer went out
+	GstClockTime last;		// timestamp of the last buffer that went out
+};
+
+class StreamRecorder;
+
+//	A stopped recording whose muxer is still writing the end of the file.
+//	The bus watch of its pipeline finishes it.
+struct RecordFinish
+{
+	StreamRecorder* recorder;
+	GstElement* pipeline;
+	QString filename;
+	guint watch;					// bus watch source id, 0 once removed
+	QElapsedTimer clock;	// time since EOS was sent
+};
+
+//	Class to save what is playing to a Matroska file without a second
+//	download or any re-encoding.  Pad probes on the decoder inputs copy the
+//	demuxed buffers into a separate appsrc ! parser ! matroskamux ! filesink
+//	pipeline.  Nothing in the playing pipeline is relinked so the recording
+//	can start and stop at any time without a glitch.  Stopping returns at
+//	once, the finished signal tells when the file is complete.
+class StreamRecorder : public QObject
+{
+	Q_OBJECT
+	
+	public:
+		StreamRecorder(QObject*);
+		~StreamRecorder();
+		
+		bool start(GstElement*, const QString&, const QString&);
+		void stop();
+		void finish(RecordFinish*, bool, const QString&);
+		inline bool isRecording() {return pipeline != NULL;}
+		inline QString fileName() {return filename;}
+		inline QString errorString() {return error;}
+	
+	signals:
+		void finished(const QString&, bool, const QString&);
+	
+	private:
+	// members
+		GstElement* pipeline;
+		GstElement* mux;
+		QList<GstElement*> sources;
+		QList<QPair<GstPad*, gulong> > probes;
+		RecordSession* session;
+		QList<RecordFinish*> finishing;
+		QString filename;
+		QString error;
+	
+	// functions
+		bool addStream(GstPad*);
+		void teardown();
+	
+	private slots:
+		void finishTimeout();
+};
+
+# endif
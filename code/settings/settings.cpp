@@ -103,6 +103,21 @@ Settings::Settings(QWidget *parent)
 	ui.lineEdit_audiocd->setText(settings->value("audio_cd_drive").toString() );
 	ui.lineEdit_dvd->setText(settings->value("dvd_drive").toString() );
 	ui.spinBox_connectionspeed->setValue(settings->value("connection_speed").toInt() );
+	ui.spinBox_ringbuffer->setValue(settings->value("ring_buffer_size").toInt() );
+	ui.checkBox_ringbuffermemory->setChecked(settings->value("ring_buffer_in_memory").toBool() );
+	ui.comboBox_profile->setCurrentText(settings->value("tuning_profile").toString() );
+	ui.checkBox_nodegradation->setChecked(settings->value("no_quality_degradation").toBool() );
+	ui.checkBox_scaletowindow->setChecked(settings->value("scale_to_window").toBool() );
+	ui.spinBox_visfps->setValue(settings->value("vis_framerate", 30).toInt() );
+	ui.lineEdit_vissize->setText(settings->value("vis_size").toString() );
+	ui.lineEdit_audiosink->setText(settings->value("audio_sink").toString() );
+	ui.spinBox_audiobuffer->setValue(settings->value("audio_buffer_time").toInt() );
+	ui.spinBox_audiolatency->setValue(settings->value("audio_latency_time").toInt() );
+	ui.comboBox_audiopriority->setCurrentText(settings->value("audio_priority").toString() );
+	ui.lineEdit_audiocpus->setText(settings->value("audio_cpus").toString() );
+	ui.lineEdit_timeshift->setText(settings->value("timeshift").toString() );
+	ui.spinBox_httpcache->setValue(settings->value("http_cache_size").toInt() );
+	ui.lineEdit_recorddir->setText(settings->value("record_dir").toString() );
 	ui.lineEdit_promoted->setText(settings->value("promoted-elements").toString() );
 	ui.lineEdit_blacklisted->setText(settings->value("blacklisted-elements").toString() );
 	settings->endGroup();
@@ -186,6 +201,21 @@ void Settings::writeSettings()
   settings->setValue("audio_cd_drive", ui.lineEdit_audiocd->text() );
   settings->setValue("dvd_drive", ui.lineEdit_dvd->text() );
   settings->setValue("connection_speed", ui.spinBox_connectionspeed->value() );
+  settings->setValue("ring_buffer_size", ui.spinBox_ringbuffer->value() );
+  settings->setValue("ring_buffer_in_memory", ui.checkBox_ringbuffermemory->isChecked() );
+  settings->setValue("tuning_profile", ui.comboBox_profile->currentText() );
+  settings->setValue("no_quality_degradation", ui.checkBox_nodegradation->isChecked() );
+  settings->setValue("scale_to_window", ui.checkBox_scaletowindow->isChecked() );
+  settings->setValue("vis_framerate", ui.spinBox_visfps->value() );
+  settings->setValue("vis_size", ui.lineEdit_vissize->text().simplified() );
+  settings->setValue("audio_sink", ui.lineEdit_audiosink->text() );
+  settings->setValue("audio_buffer_time", ui.spinBox_audiobuffer->value() );
+  settings->setValue("audio_latency_time", ui.spinBox_audiolatency->value() );
+  settings->setValue("audio_priority", ui.comboBox_audiopriority->currentText() );
+  settings->setValue("audio_cpus", ui.lineEdit_audiocpus->text() );
+  settings->setValue("timeshift", ui.lineEdit_timeshift->text() );
+  settings->setValue("http_cache_size", ui.spinBox_httpcache->value() );
+  settings->setValue("record_dir", ui.lineEdit_recorddir->text() );
   settings->setValue("promoted-elements", ui.lineEdit_promoted->text() );
   settings->setValue("blacklisted-elements", ui.lineEdit_blacklisted->text() );
   settings->endGroup();
@@ -290,6 +320,58 @@ QStringList Settings::getPlaylist()
 	return sl;
 }
 
+//
+// Function to return the decoder tuning profiles.  These are not in the UI,
+// they are an array in the DecoderProfiles group of the settings file.  If
+// the group is empty write our defaults there so they can be edited.  Keys
+// of each profile:
+//	factories		comma separated decoder names, wildcards allowed
+//	media				video or audio
+//	min_height	profile applies to streams at least this high (pixels)
+//	max_threads	max-threads property, 0 means one per core
+//	thread_type	thread-type property, 1 frame, 2 slice, 3 both
+//	skip_frame	skip-frame property used when the decoder can't keep up
+//	queue_mb		decodebin queue size in MB
+// A value of -1 leaves the decoder default.
+QList<QVariantMap> Settings::getDecoderProfiles()
+{
+	QList<QVariantMap> profiles;
+	const QStringList keys = QStringList() << "factories" << "media" << "min_height" << "max_threads" << "thread_type" << "skip_frame" << "queue_mb";
+	
+	int size = settings->beginReadArray("DecoderProfiles");
+	for (int i = 0; i < size; ++i) {
+		settings->setArrayIndex(i);
+		QVariantMap map;
+		for (int j = 0; j < keys.count(); ++j) {
+			map[keys.at(j)] = settings->value(keys.at(j), keys.at(j) == "factories" || keys.at(j) == "media" ? QVariant() : QVariant(-1) );
+		}
+		profiles << map;
+	}	// for
+	settings->endArray();
+	if (size > 0) return profiles;
+	
+	// defaults: all cores for big video, lean for small video and audio
+	QList<QVariantList> defaults;
+	defaults << (QVariantList() << "avdec_h264,avdec_h265,avdec_vp9" << "video" << 1440 << 0 << 1 << 1 << 64);
+	defaults << (QVariantList() << "avdec_*" << "video" << 720 << 0 << 3 << 1 << -1);
+	defaults << (QVariantList() << "avdec_*" << "video" << 0 << 2 << 2 << 1 << -1);
+	defaults << (QVariantList() << "*" << "audio" << 0 << 1 << -1 << -1 << -1);
+	
+	settings->beginWriteArray("DecoderProfiles");
+	for (int i = 0; i < defaults.count(); ++i) {
+		settings->setArrayIndex(i);
+		QVariantMap map;
+		for (int j = 0; j < keys.count(); ++j) {
+			map[keys.at(j)] = defaults.at(i).at(j);
+			settings->setValue(keys.at(j), defaults.at(i).at(j) );
+		}
+		profiles << map;
+	}	// for
+	settings->endArray();
+	
+	return profiles;
+}
+
 //////////////////////////////////// Private Slots /////////////////
 //
 void Settings::openEditor(QAbstractButton* button)
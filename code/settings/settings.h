@@ -63,6 +63,7 @@ class Settings : public QDialog
   	void saveElementState(const QString&, const QString&, const QVariant&);
   	void restoreElementGeometry(const QString&, QWidget*);
   	QStringList getPlaylist();
+  	QList<QVariantMap> getDecoderProfiles();
   	QVariant getSetting(const QString&, const QString&);
   	void setNotificationsTrying(const QString&); 
   	void setNotificationsConnected(const QString&);
@@ -0,0 +1,341 @@
+/**************************** spectrum.cpp *****************************
+
+Spectrum analyzer visualizer element.  Renders FFT bars or a scope of
+decimated audio into a small video frame at a low framerate.
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include <math.h>
+# include <stdlib.h>
+
+# include <gst/audio/audio.h>
+# include <gst/video/video.h>
+
+# include "./code/spectrum/spectrum.h"
+
+// Constants
+static const gint fft_size = 512;						// samples in an FFT, after decimation
+static const gint target_rate = 22050;			// decimate the audio down to about this rate
+static const gfloat min_freq = 40.0f;				// lowest frequency shown, bars are log spaced from here
+static const gfloat db_floor = -70.0f;			// level (dB below full scale) shown as an empty bar
+static const gfloat bar_decay = 0.85f;			// a bar falls to this fraction of its height each frame
+static const gfloat peak_decay = 0.02f;			// a peak marker falls this fraction of the frame each frame
+static const guint32 col_background = 0x101418;
+static const guint32 col_peak = 0xf0f0f0;
+
+// Properties and styles
+enum {PROP_0, PROP_STYLE};
+enum {STYLE_BARS = 0, STYLE_SCOPE = 1};
+
+// Pad templates, 32 bit RGB with the pixel in native byte order
+# if G_BYTE_ORDER == G_BIG_ENDIAN
+# define RGB_ORDER "xRGB"
+# else
+# define RGB_ORDER "BGRx"
+# endif
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+	GST_PAD_SINK,
+	GST_PAD_ALWAYS,
+	GST_STATIC_CAPS("audio/x-raw, format = (string) " GST_AUDIO_NE(S16) ", layout = (string) interleaved, rate = (int) [ 8000, 96000 ], channels = (int) [ 1, 2 ]") );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE("src",
+	GST_PAD_SRC,
+	GST_PAD_ALWAYS,
+	GST_STATIC_CAPS(GST_VIDEO_CAPS_MAKE(RGB_ORDER)) );
+
+G_DEFINE_TYPE(MbmpSpectrum, mbmp_spectrum, GST_TYPE_AUDIO_VISUALIZER);
+
+// Function to return the GType of the style property
+# define MBMP_TYPE_SPECTRUM_STYLE (mbmp_spectrum_style_get_type())
+static GType mbmp_spectrum_style_get_type()
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{STYLE_BARS, "Spectrum bars", "bars"},
+		{STYLE_SCOPE, "Oscilloscope", "scope"},
+		{0, NULL, NULL}
+	};
+	
+	if (! type) type = g_enum_register_static("MbmpSpectrumStyle", values);
+	return type;
+}
+
+///////////////////////////// GObject Functions /////////////////////////
+//
+static void mbmp_spectrum_set_property(GObject* object, guint prop_id, const GValue* value, GParamSpec* pspec)
+{
+	MbmpSpectrum* self = MBMP_SPECTRUM(object);
+	
+	switch (prop_id) {
+		case PROP_STYLE:
+			self->style = g_value_get_enum(value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}	// switch
+	
+	return;
+}
+
+static void mbmp_spectrum_get_property(GObject* object, guint prop_id, GValue* value, GParamSpec* pspec)
+{
+	MbmpSpectrum* self = MBMP_SPECTRUM(object);
+	
+	switch (prop_id) {
+		case PROP_STYLE:
+			g_value_set_enum(value, self->style);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}	// switch
+	
+	return;
+}
+
+static void mbmp_spectrum_finalize(GObject* object)
+{
+	MbmpSpectrum* self = MBMP_SPECTRUM(object);
+	
+	gst_fft_f32_free(self->fft);
+	g_free(self->samples);
+	g_free(self->freq);
+	g_free(self->level);
+	g_free(self->peak);
+	g_free(self->band);
+	g_free(self->rowcolor);
+	
+	G_OBJECT_CLASS(mbmp_spectrum_parent_class)->finalize(object);
+	return;
+}
+
+///////////////////////////// Visualizer Functions /////////////////////////
+//
+// Function called by the base class when the caps are known.  Work out the
+// decimation for the audio rate and lay out the bars for the frame size.
+static gboolean mbmp_spectrum_setup(GstAudioVisualizer* scope)
+{
+	MbmpSpectrum* self = MBMP_SPECTRUM(scope);
+	const gint width = GST_VIDEO_INFO_WIDTH(&scope->vinfo);
+	const gint height = GST_VIDEO_INFO_HEIGHT(&scope->vinfo);
+	const gint rate = GST_AUDIO_INFO_RATE(&scope->ainfo);
+	if (width <= 0 || height <= 0 || rate <= 0) return FALSE;
+	
+	// ask the base class for enough samples to fill an FFT each frame, at
+	// low framerates the windows simply overlap less
+	self->decimate = MAX(1, rate / target_rate);
+	scope->req_spf = fft_size * self->decimate;
+	
+	// bars about 10 pixels wide, the band edges are FFT bins spaced evenly
+	// on a log scale from min_freq to the nyquist frequency
+	g_free(self->level);
+	g_free(self->peak);
+	g_free(self->band);
+	g_free(self->rowcolor);
+	self->nbars = CLAMP(width / 10, 8, 96);
+	self->level = g_new0(gfloat, self->nbars);
+	self->peak = g_new0(gfloat, self->nbars);
+	self->band = g_new0(guint, self->nbars + 1);
+	self->rowcolor = g_new0(guint32, height);
+	
+	const gfloat nyquist = rate / (2.0f * self->decimate);
+	const gfloat hz_per_bin = nyquist / (fft_size / 2);
+	for (guint i = 0; i <= self->nbars; ++i) {
+		const gfloat f = min_freq * powf(nyquist / min_freq, static_cast<gfloat>(i) / self->nbars);
+		self->band[i] = CLAMP(static_cast<guint>(f / hz_per_bin), 1u, static_cast<guint>(fft_size / 2) );
+	}
+	
+	// green at the bottom through yellow to red at the top
+	for (gint y = 0; y < height; ++y) {
+		const gfloat t = 1.0f - static_cast<gfloat>(y) / MAX(height - 1, 1);
+		const guint32 r = t < 0.5f ? static_cast<guint32>(t * 2.0f * 255.0f) : 255;
+		const guint32 g = t < 0.5f ? 200 : static_cast<guint32>((1.0f - t) * 2.0f * 200.0f);
+		self->rowcolor[y] = (r << 16) | (g << 8) | 0x30;
+	}
+	
+	return TRUE;
+}
+
+//
+// Function to draw the spectrum bars with falling peak markers
+static void drawBars(MbmpSpectrum* self, guint32* pixels, gint stride, gint width, gint height)
+{
+	gst_fft_f32_window(self->fft, self->samples, GST_FFT_WINDOW_HANN);
+	gst_fft_f32_fft(self->fft, self->samples, self->freq);
+	
+	// a full scale sine through the Hann window peaks at 32768 * fft_size / 4
+	const gfloat norm = 32768.0f * fft_size / 4.0f;
+	const gint barw = MAX(width / static_cast<gint>(self->nbars), 1);
+	const gint gap = barw > 4 ? 2 : 0;
+	const gint xoff = (width - barw * static_cast<gint>(self->nbars)) / 2;
+	
+	for (guint i = 0; i < self->nbars; ++i) {
+		// loudest bin in the band, bands narrower than a bin get one bin
+		gfloat power = 0.0f;
+		const guint last = MAX(self->band[i + 1], self->band[i] + 1);
+		for (guint b = self->band[i]; b < last && b <= static_cast<guint>(fft_size / 2); ++b)
+			power = MAX(power, self->freq[b].r * self->freq[b].r + self->freq[b].i * self->freq[b].i);
+		const gfloat db = 10.0f * log10f(power / (norm * norm) + 1e-12f);
+		const gfloat v = CLAMP(1.0f - db / db_floor, 0.0f, 1.0f);
+		self->level[i] = MAX(v, self->level[i] * bar_decay);
+		self->peak[i] = MAX(self->level[i], self->peak[i] - peak_decay);
+		
+		const gint x0 = xoff + i * barw;
+		const gint top = height - static_cast<gint>(self->level[i] * height);
+		for (gint y = MAX(top, 0); y < height; ++y) {
+			guint32* row = pixels + y * stride + x0;
+			for (gint x = 0; x < barw - gap; ++x) row[x] = self->rowcolor[y];
+		}
+		
+		const gint py = CLAMP(height - 1 - static_cast<gint>(self->peak[i] * (height - 1)), 0, height - 1);
+		guint32* row = pixels + py * stride + x0;
+		for (gint x = 0; x < barw - gap; ++x) row[x] = col_peak;
+	}	// for each bar
+	
+	return;
+}
+
+//
+// Function to draw the waveform, n samples across the width of the frame
+static void drawScope(MbmpSpectrum* self, guint32* pixels, gint stride, gint width, gint height, gint n)
+{
+	if (n <= 0) return;
+	
+	const gint mid = height / 2;
+	gint prev = mid;
+	for (gint x = 0; x < width; ++x) {
+		const gint idx = static_cast<gint>(static_cast<gint64>(x) * n / width);
+		const gint y = CLAMP(mid - static_cast<gint>(self->samples[idx] / 32768.0f * mid), 0, height - 1);
+		
+		// a vertical line back to the last point so the trace is connected
+		for (gint yy = MIN(prev, y); yy <= MAX(prev, y); ++yy)
+			pixels[yy * stride + x] = self->rowcolor[CLAMP(height - 1 - 2 * abs(yy - mid), 0, height - 1)];
+		prev = y;
+	}	// for x
+	
+	return;
+}
+
+//
+// Function called by the base class for every video frame.  audio holds
+// req_spf samples (or more), only the newest fft_size after decimation
+// are used.
+static gboolean mbmp_spectrum_render(GstAudioVisualizer* scope, GstBuffer* audio, GstVideoFrame* video)
+{
+	MbmpSpectrum* self = MBMP_SPECTRUM(scope);
+	if (! self->nbars) return FALSE;
+	
+	GstMapInfo amap;
+	if (! gst_buffer_map(audio, &amap, GST_MAP_READ) ) return FALSE;
+	
+	// mix to mono and decimate by averaging, zero pad if we are short
+	const gint channels = GST_AUDIO_INFO_CHANNELS(&scope->ainfo);
+	const gint step = self->decimate * channels;
+	const gint frames = amap.size / (channels * sizeof(gint16) );
+	const gint n = MIN(fft_size, frames / self->decimate);
+	const gint16* src = reinterpret_cast<const gint16*>(amap.data) + (frames - n * self->decimate) * channels;
+	for (gint i = 0; i < n; ++i) {
+		gint sum = 0;
+		for (gint j = 0; j < step; ++j) sum += src[j];
+		self->samples[i] = static_cast<gfloat>(sum) / step;
+		src += step;
+	}
+	for (gint i = n; i < fft_size; ++i) self->samples[i] = 0.0f;
+	gst_buffer_unmap(audio, &amap);
+	
+	// clear the frame, then draw
+	const gint width = GST_VIDEO_FRAME_WIDTH(video);
+	const gint height = GST_VIDEO_FRAME_HEIGHT(video);
+	const gint stride = GST_VIDEO_FRAME_PLANE_STRIDE(video, 0) / sizeof(guint32);
+	guint32* pixels = static_cast<guint32*>(GST_VIDEO_FRAME_PLANE_DATA(video, 0) );
+	for (gint y = 0; y < height; ++y) {
+		guint32* row = pixels + y * stride;
+		for (gint x = 0; x < width; ++x) row[x] = col_background;
+	}
+	
+	if (self->style == STYLE_SCOPE) drawScope(self, pixels, stride, width, height, n);
+		else drawBars(self, pixels, stride, width, height);
+	
+	return TRUE;
+}
+
+///////////////////////////// Type Functions /////////////////////////
+//
+static void mbmp_spectrum_class_init(MbmpSpectrumClass* klass)
+{
+	GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+	GstElementClass* element_class = GST_ELEMENT_CLASS(klass);
+	GstAudioVisualizerClass* scope_class = GST_AUDIO_VISUALIZER_CLASS(klass);
+	
+	gobject_class->set_property = mbmp_spectrum_set_property;
+	gobject_class->get_property = mbmp_spectrum_get_property;
+	gobject_class->finalize = mbmp_spectrum_finalize;
+	
+	g_object_class_install_property(gobject_class, PROP_STYLE,
+		g_param_spec_enum("style", "Style", "How the audio is drawn", MBMP_TYPE_SPECTRUM_STYLE, STYLE_BARS,
+			static_cast<GParamFlags>(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)) );
+	
+	gst_element_class_set_static_metadata(element_class,
+		"MBMP Spectrum",
+		"Visualization",
+		"Spectrum analyzer bars or a scope drawn at a low framerate",
+		"mbmp");
+	gst_element_class_add_static_pad_template(element_class, &sink_template);
+	gst_element_class_add_static_pad_template(element_class, &src_template);
+	
+	scope_class->setup = mbmp_spectrum_setup;
+	scope_class->render = mbmp_spectrum_render;
+	
+	return;
+}
+
+static void mbmp_spectrum_init(MbmpSpectrum* self)
+{
+	self->style = STYLE_BARS;
+	self->fft = gst_fft_f32_new(fft_size, FALSE);
+	self->samples = g_new0(gfloat, fft_size);
+	self->freq = g_new0(GstFFTF32Complex, fft_size / 2 + 1);
+	self->decimate = 1;
+	self->nbars = 0;
+	self->level = NULL;
+	self->peak = NULL;
+	self->band = NULL;
+	self->rowcolor = NULL;
+	
+	// every frame is cleared in render(), the base class need not shade
+	g_object_set(G_OBJECT(self), "shader", GST_AUDIO_VISUALIZER_SHADER_NONE, NULL);
+	
+	return;
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to register the element with GStreamer so it shows up in the
+// registry like any plugin visualizer.  Call after gst_init().
+gboolean mbmp_spectrum_register()
+{
+	return gst_element_register(NULL, "mbmpspectrum", GST_RANK_NONE, MBMP_TYPE_SPECTRUM);
+}
@@ -0,0 +1,78 @@
+/**************************** spectrum.h *******************************
+
+A small spectrum analyzer visualizer element compiled into mbmp and
+registered with GStreamer at startup
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef SPECTRUM_H
+# define SPECTRUM_H
+
+# include <gst/gst.h>
+# include <gst/pbutils/gstaudiovisualizer.h>
+# include <gst/fft/gstfftf32.h>
+
+G_BEGIN_DECLS
+
+# define MBMP_TYPE_SPECTRUM (mbmp_spectrum_get_type())
+# define MBMP_SPECTRUM(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), MBMP_TYPE_SPECTRUM, MbmpSpectrum))
+
+typedef struct _MbmpSpectrum MbmpSpectrum;
+typedef struct _MbmpSpectrumClass MbmpSpectrumClass;
+
+//	Visualizer element.  Audio is mixed to mono, decimated and run through
+//	an FFT, the spectrum is drawn as log spaced bars (or the waveform as a
+//	scope) into the video frame.  The base class handles the framerate.
+struct _MbmpSpectrum
+{
+	GstAudioVisualizer parent;
+	
+	// properties
+	gint style;
+	
+	// analysis
+	GstFFTF32* fft;
+	gfloat* samples;
+	GstFFTF32Complex* freq;
+	gint decimate;
+	
+	// display, set up for the frame size in setup()
+	guint nbars;
+	gfloat* level;
+	gfloat* peak;
+	guint* band;
+	guint32* rowcolor;
+};
+
+struct _MbmpSpectrumClass
+{
+	GstAudioVisualizerClass parent_class;
+};
+
+GType mbmp_spectrum_get_type(void);
+gboolean mbmp_spectrum_register(void);
+
+G_END_DECLS
+
+# endif
@@ -56,10 +56,14 @@ StreamInfo::StreamInfo(QObject* parent) : QDialog()
 	stream_menu->addAction(ui.actionCycleVideo);
 	stream_menu->addAction(ui.actionCycleSubtitle);
 	
+	// the profile box is only shown while profiling
+	ui.groupBox_profile->setVisible(false);
+	
 	// signal and slots
 	connect (ui.comboBox_audio, SIGNAL(currentIndexChanged(int)), parent, SLOT(setAudioStream(int)));
 	connect (ui.comboBox_video, SIGNAL(currentIndexChanged(int)), parent, SLOT(setVideoStream(int)));
 	connect (ui.comboBox_subtitle, SIGNAL(currentIndexChanged(int)), parent, SLOT(setTextStream(int)));
+	connect (ui.pushButton_dot, SIGNAL(clicked()), parent, SLOT(dumpPipelineGraph()));
 	connect (ui.actionCycleAudio, SIGNAL(triggered()), this, SLOT(cycleAudioStream()));
 	connect (ui.actionCycleVideo, SIGNAL(triggered()), this, SLOT(cycleVideoStream()));	
 	connect (ui.actionCycleSubtitle, SIGNAL(triggered()), this, SLOT(cycleTextStream()));			
@@ -177,6 +181,8 @@ void StreamInfo::enableAll(bool b)
 	ui.groupBox_audio->setEnabled(b);
 	ui.groupBox_video->setEnabled(b);
 	ui.groupBox_subtitle->setEnabled(b);
+	ui.groupBox_network->setEnabled(b);
+	ui.groupBox_qos->setEnabled(b);
 	this->stream_menu->setEnabled(b);
 	
 	return;
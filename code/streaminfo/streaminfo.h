@@ -47,6 +47,9 @@ class StreamInfo : public QDialog
 		inline void updateVideoBox(const QString& sv) {ui.label_video->setText(sv);}
 		inline void updateSubtitleBox(const QString& st) {ui.label_subtitles->setText(st);}
 		inline void setSubtitleBoxEnabled(const bool& b) {ui.label_subtitles->setEnabled(b);}
+		inline void updateNetworkBox(const QString& sn) {ui.label_network->setText(sn);}
+		inline void updateQosBox(const QString& sq) {ui.label_qos->setText(sq);}
+		inline void setProfileBoxVisible(const bool& b) {ui.groupBox_profile->setVisible(b);}
 		
 		void setComboBoxes(const QMap<QString, int>&);
 		void enableAll(bool);
@@ -55,6 +58,7 @@ class StreamInfo : public QDialog
 		void cycleAudioStream();
 		void cycleVideoStream();
 		void cycleTextStream();
+		inline void updateProfileBox(const QString& sp) {ui.label_profile->setText(sp);}
 		
 	protected:
 		void contextMenuEvent(QContextMenuEvent*);	
@@ -0,0 +1,376 @@
+/**************************** thumbnailer.cpp **************************
+
+Class to extract seek bar preview images from a background pipeline
+and cache them in memory and on disk
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include <gst/app/gstappsink.h>
+# include <gst/video/video.h>
+
+# include <QtCore/QDebug>
+# include <QProcessEnvironment>
+# include <QCryptographicHash>
+# include <QFileInfo>
+# include <QFile>
+# include <QUrl>
+# include <QDateTime>
+
+# include "./code/thumbnailer/thumbnailer.h"
+# include "./code/resource.h"
+
+// Constants
+static const int thumb_width = 160;				// width of the preview image in pixels
+static const int max_tiles = 200;					// most tiles we will cache for one file
+static const int max_cached_files = 50;		// most files we keep thumbnails on disk for
+
+// Callback Function: Link the decoded video pad to our converter. Only
+// video/x-raw pads are wanted, audio and everything else is left unlinked.
+static void thumbPadAdded(GstElement* src, GstPad* pad, GstElement* convert)
+{
+	(void) src;
+
+	GstPad* sinkpad = gst_element_get_static_pad(convert, "sink");
+	if (! gst_pad_is_linked(sinkpad) ) {
+		GstCaps* caps = gst_pad_get_current_caps(pad);
+		if (! caps) caps = gst_pad_query_caps(pad, NULL);
+		if (caps) {
+			if (g_str_has_prefix(gst_structure_get_name(gst_caps_get_structure(caps, 0)), "video/x-raw") )
+				gst_pad_link(pad, sinkpad);
+			gst_caps_unref(caps);
+		}	// if caps
+	}	// if not linked
+
+	gst_object_unref(sinkpad);
+	return;
+}
+
+// Callback Function: Keep any software decoder plugged into the thumbnail
+// pipeline to a single thread so it never competes with the main playbin
+static void thumbElementAdded(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer data)
+{
+	(void) bin;
+	(void) sub_bin;
+	(void) data;
+
+	if (g_object_class_find_property(G_OBJECT_GET_CLASS(element), "max-threads") )
+		g_object_set(G_OBJECT(element), "max-threads", 1, NULL);
+
+	return;
+}
+
+/////////////////////////////// ThumbnailWorker ///////////////////////////
+//
+// Constructor
+ThumbnailWorker::ThumbnailWorker() : QObject()
+{
+	pipeline = NULL;
+	appsink = NULL;
+	current_uri.clear();
+	wanted.store(-1);
+}
+
+// Destructor
+ThumbnailWorker::~ThumbnailWorker()
+{
+	release();
+}
+
+//
+// Slot to extract the keyframe nearest secs from uri.  Called through a
+// queued connection so this runs in the worker thread.  If a newer request
+// has been made since this one was queued skip it, only the latest hover
+// position is interesting.  If filename is not empty the image is also
+// written to the disk cache.  If there is no frame extractFailed is
+// emitted so the position can be asked for again.
+void ThumbnailWorker::extract(const QString& uri, int secs, const QString& filename)
+{
+	if (secs != wanted.load() ) return;
+
+	// (re)build the pipeline if this is a new file
+	if (uri != current_uri) {
+		release();
+		if (! buildPipeline(uri) ) {
+			emit extractFailed(uri, secs);
+			return;
+		}
+	}
+
+	// keyframe seek, the new preroll buffer is our frame
+	gst_element_seek_simple(pipeline, GST_FORMAT_TIME,
+		(GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST),
+		static_cast<gint64>(secs) * GST_SECOND);
+
+	GstSample* sample = gst_app_sink_try_pull_preroll(GST_APP_SINK(appsink), 2 * GST_SECOND);
+	if (! sample) {
+		emit extractFailed(uri, secs);
+		return;
+	}
+
+	// copy the frame into a QImage
+	QImage img;
+	GstVideoInfo info;
+	GstMapInfo map;
+	GstCaps* caps = gst_sample_get_caps(sample);
+	GstBuffer* buffer = gst_sample_get_buffer(sample);
+	if (caps && buffer && gst_video_info_from_caps(&info, caps) && gst_buffer_map(buffer, &map, GST_MAP_READ) ) {
+		img = QImage(map.data,
+								GST_VIDEO_INFO_WIDTH(&info),
+								GST_VIDEO_INFO_HEIGHT(&info),
+								GST_VIDEO_INFO_PLANE_STRIDE(&info, 0),
+								QImage::Format_RGB888).copy();
+		gst_buffer_unmap(buffer, &map);
+	}
+	gst_sample_unref(sample);
+
+	if (img.isNull() ) {
+		emit extractFailed(uri, secs);
+		return;
+	}
+	if (! filename.isEmpty() ) img.save(filename, "JPG", 80);
+
+	emit frameExtracted(uri, secs, img);
+	return;
+}
+
+//
+// Slot to tear down the extraction pipeline
+void ThumbnailWorker::release()
+{
+	if (pipeline) {
+		gst_element_set_state(pipeline, GST_STATE_NULL);
+		gst_object_unref(GST_OBJECT(pipeline));
+	}
+	pipeline = NULL;
+	appsink = NULL;
+	current_uri.clear();
+
+	return;
+}
+
+//
+// Function to build the uridecodebin ! videoconvert ! videoscale ! appsink
+// pipeline for uri and bring it to PAUSED.  Return true on success.
+bool ThumbnailWorker::buildPipeline(const QString& uri)
+{
+	pipeline = gst_pipeline_new("mbmp_thumbnailer");
+	GstElement* source = gst_element_factory_make("uridecodebin", NULL);
+	GstElement* convert = gst_element_factory_make("videoconvert", NULL);
+	GstElement* scale = gst_element_factory_make("videoscale", NULL);
+	appsink = gst_element_factory_make("appsink", NULL);
+
+	if (! pipeline || ! source || ! convert || ! scale || ! appsink) {
+		qDebug() << "Thumbnailer: not all elements could be created";
+		if (pipeline) gst_object_unref(GST_OBJECT(pipeline));
+		if (source) gst_object_unref(GST_OBJECT(source));
+		if (convert) gst_object_unref(GST_OBJECT(convert));
+		if (scale) gst_object_unref(GST_OBJECT(scale));
+		if (appsink) gst_object_unref(GST_OBJECT(appsink));
+		pipeline = NULL;
+		appsink = NULL;
+		return false;
+	}
+
+	// only decode video, small RGB frames with square pixels. videoscale
+	// picks the height to keep the display aspect ratio
+	GstCaps* vcaps = gst_caps_from_string("video/x-raw");
+	g_object_set(G_OBJECT(source), "uri", qPrintable(uri), "caps", vcaps, "expose-all-streams", FALSE, NULL);
+	gst_caps_unref(vcaps);
+
+	GstCaps* caps = gst_caps_new_simple("video/x-raw",
+		"format", G_TYPE_STRING, "RGB",
+		"width", G_TYPE_INT, thumb_width,
+		"pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+		NULL);
+	g_object_set(G_OBJECT(appsink), "caps", caps, "sync", FALSE, "max-buffers", 1, "drop", TRUE, NULL);
+	gst_caps_unref(caps);
+
+	gst_bin_add_many(GST_BIN(pipeline), source, convert, scale, appsink, NULL);
+	if (! gst_element_link_many(convert, scale, appsink, NULL) ) {
+		qDebug() << "Thumbnailer: elements could not be linked";
+		gst_object_unref(GST_OBJECT(pipeline));
+		pipeline = NULL;
+		appsink = NULL;
+		return false;
+	}
+
+	g_signal_connect(source, "pad-added", G_CALLBACK(&thumbPadAdded), convert);
+	g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(&thumbElementAdded), NULL);
+
+	// preroll
+	gst_element_set_state(pipeline, GST_STATE_PAUSED);
+	if (gst_element_get_state(pipeline, NULL, NULL, 5 * GST_SECOND) == GST_STATE_CHANGE_FAILURE) {
+		release();
+		return false;
+	}
+
+	current_uri = uri;
+	return true;
+}
+
+/////////////////////////////// Thumbnailer ///////////////////////////////
+//
+// Constructor
+Thumbnailer::Thumbnailer(QObject* parent) : QObject(parent)
+{
+	// data members
+	uri.clear();
+	tile = 10;
+	pending = -1;
+	memcache.setMaxCost(max_tiles);
+
+	// setup the disk cache directory
+	QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+	cache_dir = QDir(QString(env.value("XDG_CACHE_HOME", QString(QDir::homePath()) + "/.cache") + "/%1/thumbnails").arg(QString(APP).toLower()) );
+	if (! cache_dir.exists()) cache_dir.mkpath(cache_dir.absolutePath() );
+
+	// The worker runs at idle priority. On Linux the GStreamer streaming
+	// threads it creates inherit the scheduling policy so the whole
+	// extraction pipeline stays out of the way of the main playbin.
+	thread = new QThread(this);
+	worker = new ThumbnailWorker();
+	worker->moveToThread(thread);
+
+	connect (thread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+	connect (this, SIGNAL(extractRequested(QString, int, QString)), worker, SLOT(extract(QString, int, QString)));
+	connect (this, SIGNAL(releaseRequested()), worker, SLOT(release()));
+	connect (worker, SIGNAL(frameExtracted(QString, int, QImage)), this, SLOT(frameExtracted(QString, int, QImage)));
+	connect (worker, SIGNAL(extractFailed(QString, int)), this, SLOT(extractFailed(QString, int)));
+
+	thread->start(QThread::IdlePriority);
+}
+
+// Destructor
+Thumbnailer::~Thumbnailer()
+{
+	worker->setWanted(-1);
+	thread->quit();
+	thread->wait();
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to set the media we are making thumbnails for.  Only local files
+// are handled, for a URL the second download would compete with playback.
+// duration is in seconds and sets the tile size.
+void Thumbnailer::setMedia(const QString& u, int duration)
+{
+	if (u == uri) return;
+	this->clear();
+	if (! u.startsWith("file://", Qt::CaseInsensitive) || duration <= 0) return;
+
+	uri = u;
+	tile = qMax(2, duration / max_tiles);
+
+	// per file cache directory, keyed on the file path, size and modification
+	// time so an edited file gets new thumbnails
+	QFileInfo fi(QUrl(uri).toLocalFile() );
+	QByteArray key = QString("%1|%2|%3|%4").arg(uri).arg(fi.size()).arg(fi.lastModified().toTime_t()).arg(tile).toUtf8();
+	QString sub = QString(QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex() );
+	file_dir = QDir(cache_dir.absoluteFilePath(sub) );
+	if (! file_dir.exists() ) file_dir.mkpath(file_dir.absolutePath() );
+
+	// keep the disk cache bounded, oldest files go first
+	QFileInfoList dirs = cache_dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
+	for (int i = max_cached_files; i < dirs.count(); ++i) {
+		QDir(dirs.at(i).absoluteFilePath()).removeRecursively();
+	}
+
+	return;
+}
+
+//
+// Function to request the thumbnail for a stream position in seconds.  Served
+// from memory or disk if we have it, otherwise queued to the worker.  The
+// thumbnailReady signal is emitted when an image is available.
+void Thumbnailer::requestThumbnail(int secs)
+{
+	if (! isActive() ) return;
+	const int key = tileOf(secs);
+
+	// memory cache
+	if (memcache.contains(key) ) {
+		emit thumbnailReady(key, *memcache.object(key));
+		return;
+	}
+
+	// disk cache
+	QString fn = file_dir.absoluteFilePath(QString("%1.jpg").arg(key) );
+	if (QFile::exists(fn) ) {
+		QImage* img = new QImage(fn);
+		if (! img->isNull() ) {
+			memcache.insert(key, img);
+			emit thumbnailReady(key, *img);
+			return;
+		}
+		delete img;
+	}	// if on disk
+
+	// extract it, unless already on the way
+	if (key == pending) return;
+	pending = key;
+	worker->setWanted(key);
+	emit extractRequested(uri, key, fn);
+
+	return;
+}
+
+//
+// Function to forget the current media and release the worker pipeline
+void Thumbnailer::clear()
+{
+	uri.clear();
+	memcache.clear();
+	pending = -1;
+	worker->setWanted(-1);
+	emit releaseRequested();
+
+	return;
+}
+
+//////////////////////////// Private Slots //////////////////////////
+//
+// Slot to receive a frame from the worker thread
+void Thumbnailer::frameExtracted(const QString& u, int key, const QImage& img)
+{
+	if (u != uri) return;
+
+	memcache.insert(key, new QImage(img) );
+	if (key == pending) pending = -1;
+	emit thumbnailReady(key, img);
+
+	return;
+}
+
+//
+// Slot called when the worker could not get a frame, so the next hover on
+// that position tries again
+void Thumbnailer::extractFailed(const QString& u, int key)
+{
+	if (u != uri) return;
+
+	if (key == pending) pending = -1;
+
+	return;
+}
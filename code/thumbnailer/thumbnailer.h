@@ -0,0 +1,111 @@
+/**************************** thumbnailer.h ****************************
+
+Class to extract seek bar preview images from a background pipeline
+and cache them in memory and on disk
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef THUMBNAILER_H
+# define THUMBNAILER_H
+
+# include <gst/gst.h>
+
+# include <QObject>
+# include <QThread>
+# include <QString>
+# include <QImage>
+# include <QCache>
+# include <QDir>
+# include <QAtomicInt>
+
+//	Worker class, lives in its own low priority thread and owns the
+//	frame extraction pipeline.  Only Thumbnailer should use this.
+class ThumbnailWorker : public QObject
+{
+	Q_OBJECT
+
+	public:
+		ThumbnailWorker();
+		~ThumbnailWorker();
+		inline void setWanted(int secs) {wanted.store(secs);}
+
+	public slots:
+		void extract(const QString&, int, const QString&);
+		void release();
+
+	signals:
+		void frameExtracted(const QString&, int, const QImage&);
+		void extractFailed(const QString&, int);
+
+	private:
+		// members
+		GstElement* pipeline;
+		GstElement* appsink;
+		QString current_uri;
+		QAtomicInt wanted;
+
+		// functions
+		bool buildPipeline(const QString&);
+};
+
+//	Class to provide seek bar preview images.  Frames come from a separate
+//	keyframe only pipeline and are cached in memory and on disk per file.
+class Thumbnailer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		Thumbnailer(QObject*);
+		~Thumbnailer();
+
+		void setMedia(const QString&, int);
+		void requestThumbnail(int);
+		void clear();
+		inline bool isActive() {return ! uri.isEmpty();}
+
+	signals:
+		void thumbnailReady(int, const QImage&);
+		void extractRequested(const QString&, int, const QString&);
+		void releaseRequested();
+
+	private:
+		// members
+		QThread* thread;
+		ThumbnailWorker* worker;
+		QCache<int, QImage> memcache;
+		QDir cache_dir;
+		QDir file_dir;
+		QString uri;
+		int tile;
+		int pending;
+
+		// functions
+		inline int tileOf(int secs) {return (secs / tile) * tile;}
+
+	private slots:
+		void frameExtracted(const QString&, int, const QImage&);
+		void extractFailed(const QString&, int);
+};
+
+# endif
@@ -0,0 +1,281 @@
+/**************************** urlprober.cpp ****************************
+
+Class to probe playlist URLs in the background, a HEAD request
+followed by a time limited discoverer pass
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include "./code/urlprober/urlprober.h"
+
+# include <QtCore/QDebug>
+# include <QUrl>
+# include <QTimer>
+# include <QNetworkRequest>
+
+// Constants
+static const int max_probes = 2;					// most URLs probed at the same time
+static const int head_timeout = 5;				// seconds to wait for the HEAD reply
+static const int probe_timeout = 8;				// seconds the discoverer gets per URL
+static const int dead_retry = 10 * 60;		// seconds before a dead URL is tried again
+
+/////////////////////////////// UrlProbeWorker ///////////////////////////
+//
+// Constructor
+UrlProbeWorker::UrlProbeWorker() : QObject()
+{
+	disc = NULL;
+}
+
+// Destructor
+UrlProbeWorker::~UrlProbeWorker()
+{
+	if (disc) g_object_unref(disc);
+}
+
+//
+// Slot to run the discoverer on url.  Called through a queued connection
+// so this runs in the worker thread and may block for up to probe_timeout
+// seconds.  The info (which may be NULL) is passed on with the discovered
+// signal, the receiver owns it.
+void UrlProbeWorker::discover(const QString& url)
+{
+	GError* err = NULL;
+
+	if (! disc) {
+		disc = gst_discoverer_new(probe_timeout * GST_SECOND, &err);
+		if (! disc) {
+			emit discovered(url, NULL, QString::fromUtf8(err ? err->message : "") );
+			g_clear_error(&err);
+			return;
+		}
+	}	// if no discoverer yet
+
+	GstDiscovererInfo* info = gst_discoverer_discover_uri(disc, qPrintable(url), &err);
+	const QString message = err ? QString::fromUtf8(err->message) : QString();
+	g_clear_error(&err);
+
+	emit discovered(url, info, message);
+	return;
+}
+
+/////////////////////////////// UrlProber /////////////////////////////////
+//
+// Constructor
+UrlProber::UrlProber(QObject* parent) : QObject(parent)
+{
+	// data members
+	queue.clear();
+	dead.clear();
+	qRegisterMetaType<GstDiscovererInfo*>("GstDiscovererInfo*");
+
+	nam = new QNetworkAccessManager(this);
+	connect (nam, SIGNAL(finished(QNetworkReply*)), this, SLOT(headFinished(QNetworkReply*)));
+
+	// One worker per concurrent probe, each in its own low priority thread
+	// so a slow server never holds up the others or the GUI.
+	for (int i = 0; i < max_probes; ++i) {
+		QThread* thread = new QThread(this);
+		UrlProbeWorker* worker = new UrlProbeWorker();
+		worker->moveToThread(thread);
+
+		connect (thread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+		connect (worker, SIGNAL(discovered(QString, GstDiscovererInfo*, QString)), this, SLOT(workerDone(QString, GstDiscovererInfo*, QString)));
+
+		thread->start(QThread::LowPriority);
+		threads.append(thread);
+		idle.append(worker);
+	}	// for
+}
+
+// Destructor
+UrlProber::~UrlProber()
+{
+	queue.clear();
+	for (int i = 0; i < threads.count(); ++i) {
+		threads.at(i)->quit();
+		threads.at(i)->wait();
+	}
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to queue url for probing.  The probed() signal is emitted when
+// the discoverer is done with it, unreachable() if we know it is dead.
+// Does nothing if url is already queued or being probed.
+void UrlProber::probe(const QString& url)
+{
+	if (url.isEmpty() || queue.contains(url) || busy.values().contains(url) ) return;
+
+	QString reason;
+	if (isDead(url, reason) ) {
+		emit unreachable(url, reason);
+		return;
+	}
+
+	queue.append(url);
+	this->startNext();
+
+	return;
+}
+
+//////////////////////////// Private Functions ////////////////////////////
+//
+// Function to hand queued URLs to idle workers.  http(s) URLs get a HEAD
+// request first, that is much cheaper than building a pipeline to find
+// out the host is gone.
+void UrlProber::startNext()
+{
+	while (! idle.isEmpty() && ! queue.isEmpty() ) {
+		UrlProbeWorker* worker = idle.takeFirst();
+		const QString url = queue.takeFirst();
+		busy[worker] = url;
+
+		const QString scheme = QUrl(url).scheme().toLower();
+		if (scheme == "http" || scheme == "https") {
+			const QUrl qurl(url);
+			QNetworkRequest req(qurl);
+			#if QT_VERSION >= 0x050600
+				req.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+			# endif
+			QNetworkReply* reply = nam->head(req);
+			heads[reply] = worker;
+			QTimer::singleShot(head_timeout * 1000, reply, SLOT(abort()));
+		}	// if http
+		else {
+			QMetaObject::invokeMethod(worker, "discover", Qt::QueuedConnection, Q_ARG(QString, url) );
+		}	// else
+	}	// while
+
+	return;
+}
+
+//
+// Function to remember url as dead for dead_retry seconds
+void UrlProber::markDead(const QString& url, const QString& reason)
+{
+	// keep the list from growing without bound, expired entries go first
+	const QDateTime now = QDateTime::currentDateTime();
+	QHash<QString, DeadUrl>::iterator i = dead.begin();
+	while (i != dead.end() ) {
+		if (i.value().retry <= now) i = dead.erase(i);
+		else ++i;
+	}
+
+	DeadUrl d;
+	d.reason = reason;
+	d.retry = now.addSecs(dead_retry);
+	dead[url] = d;
+
+	return;
+}
+
+//
+// Function to check the negative cache.  Return true and the reason if
+// url is known to be dead and it is too soon to try it again.
+bool UrlProber::isDead(const QString& url, QString& reason)
+{
+	if (! dead.contains(url) ) return false;
+
+	if (dead.value(url).retry <= QDateTime::currentDateTime() ) {
+		dead.remove(url);
+		return false;
+	}
+
+	reason = dead.value(url).reason;
+	return true;
+}
+
+////////////////////////////// Private Slots //////////////////////////////
+//
+// Slot called when a HEAD request finishes.  Only errors that mean the
+// media is really not there mark the URL dead.  Plenty of streaming
+// servers answer HEAD badly (or with ICY instead of HTTP), those go on to
+// the discoverer which has the final say.  A web page is left for
+// youtube-dl at play time.
+void UrlProber::headFinished(QNetworkReply* reply)
+{
+	if (! heads.contains(reply) ) return;
+	UrlProbeWorker* worker = heads.take(reply);
+	const QString url = busy.value(worker);
+	const QNetworkReply::NetworkError error = reply->error();
+	const QString reason = reply->errorString();
+	const QString type = reply->header(QNetworkRequest::ContentTypeHeader).toString();
+	reply->deleteLater();
+
+	bool b_discover = true;
+	switch (error) {
+		case QNetworkReply::HostNotFoundError:
+		case QNetworkReply::ConnectionRefusedError:
+		case QNetworkReply::ContentNotFoundError:
+		case QNetworkReply::ContentGoneError:
+			markDead(url, reason);
+			emit unreachable(url, reason);
+			b_discover = false;
+			break;
+		case QNetworkReply::OperationCanceledError:	// our timeout, try again next time
+			b_discover = false;
+			break;
+		default:
+			if (error == QNetworkReply::NoError && type.startsWith("text/html", Qt::CaseInsensitive) ) b_discover = false;
+			break;
+	}	// switch
+
+	if (b_discover) {
+		QMetaObject::invokeMethod(worker, "discover", Qt::QueuedConnection, Q_ARG(QString, url) );
+	}
+	else {
+		busy.remove(worker);
+		idle.append(worker);
+		this->startNext();
+	}
+
+	return;
+}
+
+//
+// Slot called when a worker is done with a URL.  The info is only good
+// for the duration of the probed() signal, receivers must copy what they
+// need out of it.
+void UrlProber::workerDone(const QString& url, GstDiscovererInfo* info, const QString& message)
+{
+	UrlProbeWorker* worker = qobject_cast<UrlProbeWorker*>(sender());
+	if (worker && busy.contains(worker) ) {
+		busy.remove(worker);
+		idle.append(worker);
+	}
+
+	if (! info) {
+		markDead(url, message);
+		emit unreachable(url, message);
+	}
+	else {
+		const GstDiscovererResult result = gst_discoverer_info_get_result(info);
+		if (result == GST_DISCOVERER_URI_INVALID || result == GST_DISCOVERER_ERROR) markDead(url, message);
+		emit probed(url, info, message);
+		gst_discoverer_info_unref(info);
+	}	// else
+
+	this->startNext();
+	return;
+}
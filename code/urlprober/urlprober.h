@@ -0,0 +1,115 @@
+/**************************** urlprober.h ******************************
+
+Class to probe playlist URLs in the background, a HEAD request
+followed by a time limited discoverer pass
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef URLPROBER_H
+# define URLPROBER_H
+
+# include <gst/gst.h>
+# include <gst/pbutils/pbutils.h>
+
+# include <QObject>
+# include <QThread>
+# include <QString>
+# include <QStringList>
+# include <QList>
+# include <QMap>
+# include <QHash>
+# include <QDateTime>
+# include <QMetaType>
+# include <QNetworkAccessManager>
+# include <QNetworkReply>
+
+Q_DECLARE_METATYPE(GstDiscovererInfo*)
+
+//	A URL that could not be reached and when we may try it again
+struct DeadUrl
+{
+	QString reason;
+	QDateTime retry;
+};
+
+//	Worker class, lives in its own thread and runs the discoverer on one
+//	URL at a time.  Only UrlProber should use this.
+class UrlProbeWorker : public QObject
+{
+	Q_OBJECT
+
+	public:
+		UrlProbeWorker();
+		~UrlProbeWorker();
+
+	public slots:
+		void discover(const QString&);
+
+	signals:
+		void discovered(const QString&, GstDiscovererInfo*, const QString&);
+
+	private:
+		// members
+		GstDiscoverer* disc;
+};
+
+//	Class to fill in playlist URL items without blocking the GUI.  A HEAD
+//	request weeds out dead links quickly, then the discoverer gets the
+//	duration, seekability and tags.  At most a few URLs are probed at once
+//	and dead URLs are remembered for a while.
+class UrlProber : public QObject
+{
+	Q_OBJECT
+
+	public:
+		UrlProber(QObject*);
+		~UrlProber();
+
+		void probe(const QString&);
+
+	signals:
+		void probed(const QString&, GstDiscovererInfo*, const QString&);
+		void unreachable(const QString&, const QString&);
+
+	private:
+		// members
+		QList<QThread*> threads;
+		QList<UrlProbeWorker*> idle;
+		QMap<QNetworkReply*, UrlProbeWorker*> heads;
+		QMap<UrlProbeWorker*, QString> busy;
+		QStringList queue;
+		QHash<QString, DeadUrl> dead;
+		QNetworkAccessManager* nam;
+
+		// functions
+		void startNext();
+		void markDead(const QString&, const QString&);
+		bool isDead(const QString&, QString&);
+
+	private slots:
+		void headFinished(QNetworkReply*);
+		void workerDone(const QString&, GstDiscovererInfo*, const QString&);
+};
+
+# endif
@@ -0,0 +1,203 @@
+/**************************** urlresolver.cpp **************************
+
+Class to resolve page URLs to media URLs with youtube-dl in the
+background, with a cache of the results
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# include "./code/urlresolver/urlresolver.h"
+
+# include <QUrl>
+# include <QUrlQuery>
+# include <QTimer>
+# include <QStringList>
+
+// Constants
+static const int default_lifetime = 30 * 60;		// seconds a media URL without an expire= parameter is good for
+static const int expiry_margin = 5 * 60;				// seconds before expiry we stop trusting it
+static const int max_cached = 50;								// most resolved URLs we keep
+
+// Constructor
+UrlResolver::UrlResolver(QObject* parent) : QObject(parent)
+{
+	cache.clear();
+	running.clear();
+	wanted.clear();
+	timeout = 10;
+}
+
+// Destructor
+UrlResolver::~UrlResolver()
+{
+	QMap<QProcess*, QString>::const_iterator i;
+	for (i = running.constBegin(); i != running.constEnd(); ++i) {
+		i.key()->disconnect(this);
+		i.key()->kill();
+		i.key()->waitForFinished(1000);
+	}
+}
+
+///////////////////////////// Public Functions /////////////////////////
+//
+// Function to look url up in the cache.  Return true and the media URL in
+// media if we have a result that has not expired.
+bool UrlResolver::lookup(const QString& url, QString& media)
+{
+	if (! cache.contains(url) ) return false;
+	
+	if (cache.value(url).expires <= QDateTime::currentDateTime() ) {
+		cache.remove(url);
+		return false;
+	}
+	
+	media = cache.value(url).media;
+	return true;
+}
+
+//
+// Function to resolve url for playing.  The resolved() or failed() signal
+// is emitted when youtube-dl is done, right away from the event loop if
+// the result is cached.  A resolve for a URL already being prefetched just
+// waits for that process.
+void UrlResolver::resolve(const QString& url)
+{
+	wanted = url;
+	
+	QString media;
+	if (lookup(url, media) ) {
+		QMetaObject::invokeMethod(this, "resolved", Qt::QueuedConnection, Q_ARG(QString, url), Q_ARG(QString, media) );
+		return;
+	}
+	
+	if (! running.values().contains(url) ) startProcess(url);
+	
+	return;
+}
+
+//
+// Function to resolve url in the background and only cache the result.
+// Does nothing if it is cached or already being resolved.
+void UrlResolver::prefetch(const QString& url)
+{
+	QString media;
+	if (url.isEmpty() || lookup(url, media) || running.values().contains(url) ) return;
+	
+	startProcess(url);
+	return;
+}
+
+//////////////////////////// Private Functions ////////////////////////////
+//
+// Function to start youtube-dl for url, killed after timeout seconds
+void UrlResolver::startProcess(const QString& url)
+{
+	QProcess* p = new QProcess(this);
+	running[p] = url;
+	connect (p, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(processFinished(int, QProcess::ExitStatus)));
+	connect (p, SIGNAL(error(QProcess::ProcessError)), this, SLOT(processError(QProcess::ProcessError)));
+	QTimer::singleShot(timeout * 1000, p, SLOT(kill()));
+	
+	p->start("youtube-dl", QStringList() << "-g" << "-f" << "best" << url);
+	
+	return;
+}
+
+//
+// Function to work out when a media URL expires.  Google video URLs carry
+// an expire= parameter (seconds since the epoch), otherwise assume
+// default_lifetime.
+QDateTime UrlResolver::expiryOf(const QString& media)
+{
+	const QDateTime now = QDateTime::currentDateTime();
+	const QString expire = QUrlQuery(QUrl(media)).queryItemValue("expire");
+	bool ok = false;
+	const qint64 secs = expire.toLongLong(&ok);
+	if (ok && secs > 0) {
+		const QDateTime t = QDateTime::fromMSecsSinceEpoch(secs * 1000).addSecs(-expiry_margin);
+		return t > now ? t : now;
+	}
+	
+	return now.addSecs(default_lifetime);
+}
+
+////////////////////////////// Private Slots //////////////////////////////
+//
+// Slot called when a youtube-dl process ends.  Cache a good result and
+// report it if it is the URL we want to play.
+void UrlResolver::processFinished(int code, QProcess::ExitStatus status)
+{
+	QProcess* p = qobject_cast<QProcess*>(sender());
+	if (! p || ! running.contains(p) ) return;
+	const QString url = running.take(p);
+	const QString media = QString::fromUtf8(p->readAllStandardOutput()).section('\n', 0, 0).trimmed();
+	const QString err = QString::fromUtf8(p->readAllStandardError()).trimmed();
+	p->deleteLater();
+	
+	if (status != QProcess::NormalExit || code != 0 || media.isEmpty() ) {
+		if (url == wanted) {
+			wanted.clear();
+			emit failed(url, err.isEmpty() ? tr("youtube-dl did not finish in time") : err);
+		}
+		return;
+	}
+	
+	// keep the cache bounded, drop the entry closest to expiry
+	if (cache.count() >= max_cached) {
+		QMap<QString, ResolvedUrl>::iterator oldest = cache.begin();
+		for (QMap<QString, ResolvedUrl>::iterator i = cache.begin(); i != cache.end(); ++i) {
+			if (i.value().expires < oldest.value().expires) oldest = i;
+		}
+		cache.erase(oldest);
+	}
+	ResolvedUrl r;
+	r.media = media;
+	r.expires = expiryOf(media);
+	cache[url] = r;
+	
+	if (url == wanted) {
+		wanted.clear();
+		emit resolved(url, media);
+	}
+	
+	return;
+}
+
+//
+// Slot called when youtube-dl could not be started at all
+void UrlResolver::processError(QProcess::ProcessError error)
+{
+	if (error != QProcess::FailedToStart) return;
+	
+	QProcess* p = qobject_cast<QProcess*>(sender());
+	if (! p || ! running.contains(p) ) return;
+	const QString url = running.take(p);
+	p->deleteLater();
+	
+	if (url == wanted) {
+		wanted.clear();
+		emit failed(url, tr("youtube-dl could not be started"));
+	}
+	
+	return;
+}
@@ -0,0 +1,81 @@
+/**************************** urlresolver.h ****************************
+
+Class to resolve page URLs to media URLs with youtube-dl in the
+background, with a cache of the results
+
+Copyright (C) 2014-2019
+by: Andrew J. Bibb
+License: MIT 
+
+Permission is hereby granted, free of charge, to any person obtaining a copy 
+of this software and associated documentation files (the "Software"),to deal 
+in the Software without restriction, including without limitation the rights 
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+copies of the Software, and to permit persons to whom the Software is 
+furnished to do so, subject to the following conditions: 
+
+The above copyright notice and this permission notice shall be included 
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+DEALINGS IN THE SOFTWARE.
+***********************************************************************/ 
+
+# ifndef URLRESOLVER_H
+# define URLRESOLVER_H
+
+# include <QObject>
+# include <QString>
+# include <QMap>
+# include <QDateTime>
+# include <QProcess>
+
+//	A resolved URL and when it stops being good
+struct ResolvedUrl
+{
+	QString media;
+	QDateTime expires;
+};
+
+//	Class to run youtube-dl without blocking the GUI.  Results are cached
+//	until the media URL expires so a replay or a prefetched Next starts
+//	right away.
+class UrlResolver : public QObject
+{
+	Q_OBJECT
+	
+	public:
+		UrlResolver(QObject*);
+		~UrlResolver();
+		
+		bool lookup(const QString&, QString&);
+		void resolve(const QString&);
+		void prefetch(const QString&);
+		inline void setTimeout(int secs) {timeout = secs;}
+		
+	signals:
+		void resolved(const QString&, const QString&);
+		void failed(const QString&, const QString&);
+		
+	private:
+	// members
+		QMap<QString, ResolvedUrl> cache;
+		QMap<QProcess*, QString> running;
+		QString wanted;
+		int timeout;
+		
+	// functions
+		void startProcess(const QString&);
+		QDateTime expiryOf(const QString&);
+		
+	private slots:
+		void processFinished(int, QProcess::ExitStatus);
+		void processError(QProcess::ProcessError);
+};
+
+# endif
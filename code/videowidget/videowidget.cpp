@@ -31,6 +31,8 @@ DEALINGS IN THE SOFTWARE.
 
 # include "./code/videowidget/videowidget.h"	
 
+// Constants
+static const int render_rect_interval = 40;	// ms between render rectangle updates during a resize
 
 // Constructor
 VideoWidget::VideoWidget(QWidget* parent) : QWidget(parent)
@@ -46,6 +48,33 @@ VideoWidget::VideoWidget(QWidget* parent) : QWidget(parent)
 	
 	setFocusPolicy(Qt::StrongFocus);
 	
+	// the video sink draws on our native window, we tell it where through
+	// the render rectangle.  Resizes arrive in bursts so only pass one on
+	// every render_rect_interval.
+	video_active = false;
+	rect_timer = new QTimer(this);
+	rect_timer->setSingleShot(true);
+	rect_timer->setInterval(render_rect_interval);
+	connect (rect_timer, SIGNAL(timeout()), this, SLOT(sendRenderRect()));
+}
+
+///////////////////// Public Functions /////////////////////////////
+//
+// Function to tell us if a video sink is drawing on the window.  While it
+// is Qt must not paint the background over the video, repaints are done
+// by asking the sink to expose its last frame.  When it stops fill the
+// window with black again.
+void VideoWidget::setVideoActive(bool b)
+{
+	if (b == video_active) return;
+	video_active = b;
+	
+	this->setAutoFillBackground(! b);
+	this->setAttribute(Qt::WA_OpaquePaintEvent, b);
+	if (b) sendRenderRect();
+		else this->update();
+	
+	return;
 }
 
 ///////////////////// Protected Functions /////////////////////////////
@@ -100,3 +129,39 @@ void VideoWidget::keyReleaseEvent(QKeyEvent* e)
 {
 	e->accept();
 }
+
+//
+// With a video sink active have it redraw its last frame rather than
+// painting anything ourselves.  During a resize the render rectangle update
+// comes with its own expose so skip it here.
+void VideoWidget::paintEvent(QPaintEvent* e)
+{
+	if (video_active) {
+		if (! rect_timer->isActive() ) emit exposeRequested();
+		e->accept();
+	}
+	else QWidget::paintEvent(e);
+	
+	return;
+}
+
+//
+// Throttle resizes.  The first one starts the timer, those that come while
+// it runs are picked up when it fires so the last size always gets through.
+void VideoWidget::resizeEvent(QResizeEvent* e)
+{
+	QWidget::resizeEvent(e);
+	if (! rect_timer->isActive() ) rect_timer->start();
+	
+	return;
+}
+
+///////////////////// Private Slots /////////////////////////////
+//
+// Slot to send the render rectangle, the whole widget in device pixels
+void VideoWidget::sendRenderRect()
+{
+	emit renderRectChanged(QRect(QPoint(0, 0), this->size() * this->devicePixelRatio()) );
+	
+	return;
+}
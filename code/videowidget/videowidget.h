@@ -33,6 +33,10 @@ DEALINGS IN THE SOFTWARE.
 # include <QMouseEvent>
 # include <QKeyEvent>
 # include <QString>
+# include <QRect>
+# include <QTimer>
+# include <QPaintEvent>
+# include <QResizeEvent>
 
 class VideoWidget : public QWidget 
 {	
@@ -40,9 +44,13 @@ class VideoWidget : public QWidget
 
   public:
 		VideoWidget (QWidget*);
+		void setVideoActive(bool);
+		inline bool isVideoActive() {return video_active;}
 		
 	signals:
 		void navsignal (QString event, int button, int x, int y); 	
+		void renderRectChanged (const QRect&);
+		void exposeRequested ();
 		
 	protected:
 		void	mouseDoubleClickEvent(QMouseEvent*);
@@ -51,6 +59,15 @@ class VideoWidget : public QWidget
 		void	mouseReleaseEvent(QMouseEvent*);	
 		void keyPressEvent(QKeyEvent*);
 		void keyReleaseEvent(QKeyEvent*);
+		void paintEvent(QPaintEvent*);
+		void resizeEvent(QResizeEvent*);
+		
+	private:
+		QTimer* rect_timer;
+		bool video_active;
+		
+	private slots:
+		void sendRenderRect();
 };
 
 #endif
@@ -65,6 +65,15 @@ HEADERS		+= ./code/ipc/mediaplayer2.h
 HEADERS		+= ./code/ipc/mediaplayer2player.h
 HEADERS		+= ./code/mbman/mbman.h
 HEADERS		+= ./code/artwidget/artwidget.h
+HEADERS		+= ./code/thumbnailer/thumbnailer.h
+HEADERS		+= ./code/decbench/decbench.h
+HEADERS		+= ./code/profiler/profiler.h
+HEADERS		+= ./code/spectrum/spectrum.h
+HEADERS		+= ./code/colorbalance/colorbalance.h
+HEADERS		+= ./code/mediacache/mediacache.h
+HEADERS		+= ./code/urlresolver/urlresolver.h
+HEADERS		+= ./code/urlprober/urlprober.h
+HEADERS		+= ./code/recorder/recorder.h
 
 #	forms
 FORMS		+= ./code/playerctl/ui/playerctl.ui
@@ -72,6 +81,7 @@ FORMS		+= ./code/playlist/ui/playlist.ui
 FORMS		+= ./code/streaminfo/ui/streaminfo.ui
 FORMS		+= ./code/scrollbox/ui/scrollbox.ui
 FORMS		+= ./code/settings/ui/settings.ui
+FORMS		+= ./code/colorbalance/ui/colorbalance.ui
 
 #	sources
 SOURCES	+= ./code/main.cpp
@@ -91,6 +101,15 @@ SOURCES += ./code/ipc/mediaplayer2.cpp
 SOURCES += ./code/ipc/mediaplayer2player.cpp
 SOURCES += ./code/mbman/mbman.cpp
 SOURCES += ./code/artwidget/artwidget.cpp
+SOURCES += ./code/thumbnailer/thumbnailer.cpp
+SOURCES += ./code/decbench/decbench.cpp
+SOURCES += ./code/profiler/profiler.cpp
+SOURCES += ./code/spectrum/spectrum.cpp
+SOURCES += ./code/colorbalance/colorbalance.cpp
+SOURCES += ./code/mediacache/mediacache.cpp
+SOURCES += ./code/urlresolver/urlresolver.cpp
+SOURCES += ./code/urlprober/urlprober.cpp
+SOURCES += ./code/recorder/recorder.cpp
 
 #	resource files
 RESOURCES 	+= mbmp.qrc
@@ -113,6 +132,9 @@ CONFIG += link_pkgconfig
 PKGCONFIG += gstreamer-1.0
 PKGCONFIG += gstreamer-video-1.0
 PKGCONFIG += gstreamer-pbutils-1.0
+PKGCONFIG += gstreamer-app-1.0
+PKGCONFIG += gstreamer-audio-1.0
+PKGCONFIG += gstreamer-fft-1.0
 PKGCONFIG += x11
 PKGCONFIG += xext
 